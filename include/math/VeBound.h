@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeBound.h
+ * \brief The axis aligned bounding box
+ */
+
+#pragma once
+
+#include <include/math/VeVector.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace Vedo {
+/**
+ * The axis aligned bounding box
+ */
+struct Bound {
+	Vec3 Min;
+	Vec3 Max;
+
+	/**
+	 * Make an empty bound, expanding it by any point gets the bound of the point
+	 */
+	static Bound Empty() {
+		constexpr auto infinity = std::numeric_limits<float>::infinity();
+		return {Vec3{infinity, infinity, infinity}, Vec3{-infinity, -infinity, -infinity}};
+	}
+	/**
+	 * Expand the bound to contain the point
+	 * @param Point The point to be contained
+	 */
+	void Expand(const Vec3 &Point) {
+		Min = {std::min(Min.x, Point.x), std::min(Min.y, Point.y), std::min(Min.z, Point.z)};
+		Max = {std::max(Max.x, Point.x), std::max(Max.y, Point.y), std::max(Max.z, Point.z)};
+	}
+	/**
+	 * Expand the bound to contain another bound
+	 * @param Target The bound to be contained
+	 */
+	void Expand(const Bound &Target) {
+		Expand(Target.Min);
+		Expand(Target.Max);
+	}
+	/**
+	 * Get the surface area of the bound, an empty bound has no area
+	 */
+	[[nodiscard]] float Area() const {
+		auto extent = Max - Min;
+		if (extent.x < 0 || extent.y < 0 || extent.z < 0) {
+			return 0;
+		}
+
+		return 2 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+	/**
+	 * Get the center of the bound
+	 */
+	[[nodiscard]] Vec3 Centroid() const {
+		return (Min + Max) * 0.5f;
+	}
+};
+} // namespace Vedo
\ No newline at end of file
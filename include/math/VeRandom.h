@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeRandom.h
+ * \brief The random number generator of Vedo native render
+ */
+
+#pragma once
+
+#include <include/math/VeSIMD.h>
+
+namespace Vedo {
+/**
+ * The PCG hash of a 32-bit integer (PCG-RXS-M-XS), used to seed the generators
+ * @param Value The integer to be hashed
+ * @return The hashed integer
+ */
+constexpr uint32_t PCGHash(uint32_t Value) {
+	uint32_t state = Value * 747796405u + 2891336453u;
+	uint32_t word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+
+	return (word >> 22u) ^ word;
+}
+
+/**
+ * The random numbers of a ray packet, each lane is a PCG32 stream of its own. A stream is seeded by
+ * the pixel, the pass and the sample, then it goes on through the bounces of the path, so every
+ * sample and every bounce takes independent numbers. SSE2 has no 32-bit multiplication in lanes, so
+ * the lanes are stepped one by one, which the compiler vectorizes where it can
+ */
+class SIMDRandom {
+public:
+	/**
+	 * Seed the streams of the lanes
+	 * @param X The x coordinate of the pixel of each lane
+	 * @param Y The y coordinate of the pixel of each lane
+	 * @param Seed The seed of the pass
+	 * @param Sample The index of the sample in the pass
+	 */
+	SIMDRandom(const SIMDFloat &X, const SIMDFloat &Y, uint32_t Seed, uint32_t Sample) {
+		float x[SIMDWidth];
+		float y[SIMDWidth];
+		X.Store(x);
+		Y.Store(y);
+		for (int lane = 0; lane < SIMDWidth; ++lane) {
+			_state[lane] = PCGHash(PCGHash(PCGHash(PCGHash(static_cast<uint32_t>(x[lane])) ^
+												   static_cast<uint32_t>(y[lane])) ^
+										   Seed) ^
+								   Sample);
+		}
+	}
+
+public:
+	/**
+	 * Take the next uniform number in [0, 1) of each lane, rotated by the point of a sample dimension
+	 * like NextSample() in path_tracing.sksl
+	 * @param Point The point of the dimension shared by the lanes, 0 takes the number as it is
+	 */
+	SIMDFloat Next(float Point = 0.f) {
+		float value[SIMDWidth];
+		for (int lane = 0; lane < SIMDWidth; ++lane) {
+			auto state	 = _state[lane];
+			_state[lane] = state * 747796405u + 2891336453u;
+
+			// The permutation of PCG-RXS-M-XS, the top 24 bits are exact in a float
+			uint32_t word	= ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+			auto	 sample = static_cast<float>(((word >> 22u) ^ word) >> 8u) * (1.f / 16777216.f) + Point;
+			value[lane]		= sample >= 1.f ? sample - 1.f : sample;
+		}
+
+		return SIMDFloat::Load(value);
+	}
+	/**
+	 * Take a uniform vector on the unit sphere of each lane, the same as randomUnitVector() in
+	 * path_tracing.sksl
+	 * @param PointX The point of the first dimension
+	 * @param PointY The point of the second dimension
+	 */
+	SIMDVec3 NextUnitVector(float PointX = 0.f, float PointY = 0.f) {
+		auto u = Next(PointX);
+		auto v = Next(PointY);
+
+		const auto one = SIMDFloat::Broadcast(1.f);
+
+		auto z		= one - SIMDFloat::Broadcast(2.f) * u;
+		auto radius = Sqrt(Max(one - z * z, SIMDFloat::Broadcast(0.f)));
+		auto phi	= SIMDFloat::Broadcast(6.28318530717959f) * v;
+
+		// sin(phi) is the cosine a quarter turn behind
+		auto cosine = Cos(phi);
+		auto sine	= Cos(phi - SIMDFloat::Broadcast(1.57079632679490f));
+
+		return {radius * cosine, radius * sine, z};
+	}
+	/**
+	 * Take a uniform point in the unit disk of each lane, the same as randomInUnitDisk() in
+	 * path_tracing.sksl
+	 * @param PointX The point of the first dimension
+	 * @param PointY The point of the second dimension
+	 */
+	SIMDVec3 NextInUnitDisk(float PointX = 0.f, float PointY = 0.f) {
+		auto radius = Sqrt(Next(PointX));
+		auto theta	= SIMDFloat::Broadcast(6.28318530717959f) * Next(PointY);
+
+		return {radius * Cos(theta), radius * Cos(theta - SIMDFloat::Broadcast(1.57079632679490f)),
+				SIMDFloat::Broadcast(0.f)};
+	}
+
+private:
+	uint32_t _state[SIMDWidth];
+};
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeSIMD.h
+ * \brief The SIMD lane wrapper of Vedo Render
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#	define VE_SIMD_AVX2
+#	include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define VE_SIMD_SSE
+#	include <emmintrin.h>
+#endif
+
+namespace Vedo {
+#if defined(VE_SIMD_AVX2)
+/**
+ * The count of the lanes in a SIMD register, a ray packet holds one ray per lane
+ */
+constexpr int SIMDWidth = 8;
+#elif defined(VE_SIMD_SSE)
+constexpr int SIMDWidth = 4;
+#else
+constexpr int SIMDWidth = 1;
+#endif
+
+/**
+ * The lane mask of the SIMD float, produced by the comparisons
+ */
+class SIMDMask {
+public:
+#if defined(VE_SIMD_AVX2)
+	using Register = __m256;
+#elif defined(VE_SIMD_SSE)
+	using Register = __m128;
+#else
+	using Register = bool;
+#endif
+
+public:
+	SIMDMask() = default;
+	explicit SIMDMask(Register Value) : Value(Value) {
+	}
+	/**
+	 * Make the mask with all the lanes set to the value
+	 * @param Flag The value of the lanes
+	 */
+	static SIMDMask Broadcast(bool Flag) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDMask(Flag ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : _mm256_setzero_ps());
+#elif defined(VE_SIMD_SSE)
+		return SIMDMask(Flag ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : _mm_setzero_ps());
+#else
+		return SIMDMask(Flag);
+#endif
+	}
+
+public:
+	/**
+	 * Whether any lane is set
+	 */
+	[[nodiscard]] bool Any() const {
+#if defined(VE_SIMD_AVX2)
+		return _mm256_movemask_ps(Value) != 0;
+#elif defined(VE_SIMD_SSE)
+		return _mm_movemask_ps(Value) != 0;
+#else
+		return Value;
+#endif
+	}
+	/**
+	 * Whether the lane is set
+	 * @param Lane The index of the lane
+	 */
+	[[nodiscard]] bool Lane(int Lane) const {
+#if defined(VE_SIMD_AVX2)
+		return (_mm256_movemask_ps(Value) >> Lane) & 1;
+#elif defined(VE_SIMD_SSE)
+		return (_mm_movemask_ps(Value) >> Lane) & 1;
+#else
+		return Value;
+#endif
+	}
+
+public:
+	friend SIMDMask operator&(const SIMDMask &Left, const SIMDMask &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDMask(_mm256_and_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDMask(_mm_and_ps(Left.Value, Right.Value));
+#else
+		return SIMDMask(Left.Value && Right.Value);
+#endif
+	}
+	friend SIMDMask operator|(const SIMDMask &Left, const SIMDMask &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDMask(_mm256_or_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDMask(_mm_or_ps(Left.Value, Right.Value));
+#else
+		return SIMDMask(Left.Value || Right.Value);
+#endif
+	}
+	/**
+	 * The lanes set in the left mask but not in the right mask
+	 */
+	friend SIMDMask AndNot(const SIMDMask &Left, const SIMDMask &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDMask(_mm256_andnot_ps(Right.Value, Left.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDMask(_mm_andnot_ps(Right.Value, Left.Value));
+#else
+		return SIMDMask(Left.Value && !Right.Value);
+#endif
+	}
+
+public:
+	Register Value;
+};
+
+/**
+ * The float lanes of a SIMD register, the operations are applied to every lane. It falls back to
+ * a single scalar lane when neither AVX2 nor SSE is available
+ */
+class SIMDFloat {
+public:
+#if defined(VE_SIMD_AVX2)
+	using Register = __m256;
+#elif defined(VE_SIMD_SSE)
+	using Register = __m128;
+#else
+	using Register = float;
+#endif
+
+public:
+	SIMDFloat() = default;
+	explicit SIMDFloat(Register Value) : Value(Value) {
+	}
+	/**
+	 * Make the lanes with the same value
+	 * @param Scalar The value of the lanes
+	 */
+	static SIMDFloat Broadcast(float Scalar) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_set1_ps(Scalar));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_set1_ps(Scalar));
+#else
+		return SIMDFloat(Scalar);
+#endif
+	}
+	/**
+	 * Load the lanes from the memory
+	 * @param Data The pointer to SIMDWidth floats, it does not need to be aligned
+	 */
+	static SIMDFloat Load(const float *Data) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_loadu_ps(Data));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_loadu_ps(Data));
+#else
+		return SIMDFloat(*Data);
+#endif
+	}
+	/**
+	 * Make the lanes with the value of Base + Lane index, 0, 1, 2...
+	 * @param Base The value of the first lane
+	 */
+	static SIMDFloat Sequence(float Base) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_add_ps(_mm256_set1_ps(Base), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_add_ps(_mm_set1_ps(Base), _mm_setr_ps(0, 1, 2, 3)));
+#else
+		return SIMDFloat(Base);
+#endif
+	}
+
+public:
+	/**
+	 * Store the lanes into the memory
+	 * @param Data The pointer to SIMDWidth floats, it does not need to be aligned
+	 */
+	void Store(float *Data) const {
+#if defined(VE_SIMD_AVX2)
+		_mm256_storeu_ps(Data, Value);
+#elif defined(VE_SIMD_SSE)
+		_mm_storeu_ps(Data, Value);
+#else
+		*Data = Value;
+#endif
+	}
+
+public:
+	friend SIMDFloat operator+(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_add_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_add_ps(Left.Value, Right.Value));
+#else
+		return SIMDFloat(Left.Value + Right.Value);
+#endif
+	}
+	friend SIMDFloat operator-(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_sub_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_sub_ps(Left.Value, Right.Value));
+#else
+		return SIMDFloat(Left.Value - Right.Value);
+#endif
+	}
+	friend SIMDFloat operator*(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_mul_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_mul_ps(Left.Value, Right.Value));
+#else
+		return SIMDFloat(Left.Value * Right.Value);
+#endif
+	}
+	friend SIMDFloat operator/(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_div_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_div_ps(Left.Value, Right.Value));
+#else
+		return SIMDFloat(Left.Value / Right.Value);
+#endif
+	}
+	friend SIMDFloat operator-(const SIMDFloat &Value) {
+		return Broadcast(0.f) - Value;
+	}
+	SIMDFloat &operator+=(const SIMDFloat &Right) {
+		return *this = *this + Right;
+	}
+	SIMDFloat &operator*=(const SIMDFloat &Right) {
+		return *this = *this * Right;
+	}
+
+public:
+	friend SIMDMask operator<(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDMask(_mm256_cmp_ps(Left.Value, Right.Value, _CMP_LT_OQ));
+#elif defined(VE_SIMD_SSE)
+		return SIMDMask(_mm_cmplt_ps(Left.Value, Right.Value));
+#else
+		return SIMDMask(Left.Value < Right.Value);
+#endif
+	}
+	friend SIMDMask operator>(const SIMDFloat &Left, const SIMDFloat &Right) {
+		return Right < Left;
+	}
+	friend SIMDMask operator<=(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDMask(_mm256_cmp_ps(Left.Value, Right.Value, _CMP_LE_OQ));
+#elif defined(VE_SIMD_SSE)
+		return SIMDMask(_mm_cmple_ps(Left.Value, Right.Value));
+#else
+		return SIMDMask(Left.Value <= Right.Value);
+#endif
+	}
+	friend SIMDMask operator>=(const SIMDFloat &Left, const SIMDFloat &Right) {
+		return Right <= Left;
+	}
+
+public:
+	/**
+	 * Select the lanes from two values by the mask
+	 * @param Mask The lane mask
+	 * @param True The value of the set lanes
+	 * @param False The value of the unset lanes
+	 */
+	friend SIMDFloat Select(const SIMDMask &Mask, const SIMDFloat &True, const SIMDFloat &False) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_blendv_ps(False.Value, True.Value, Mask.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_or_ps(_mm_and_ps(Mask.Value, True.Value), _mm_andnot_ps(Mask.Value, False.Value)));
+#else
+		return SIMDFloat(Mask.Value ? True.Value : False.Value);
+#endif
+	}
+	friend SIMDFloat Min(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_min_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_min_ps(Left.Value, Right.Value));
+#else
+		return SIMDFloat(std::min(Left.Value, Right.Value));
+#endif
+	}
+	friend SIMDFloat Max(const SIMDFloat &Left, const SIMDFloat &Right) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_max_ps(Left.Value, Right.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_max_ps(Left.Value, Right.Value));
+#else
+		return SIMDFloat(std::max(Left.Value, Right.Value));
+#endif
+	}
+	friend SIMDFloat Sqrt(const SIMDFloat &Value) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_sqrt_ps(Value.Value));
+#elif defined(VE_SIMD_SSE)
+		return SIMDFloat(_mm_sqrt_ps(Value.Value));
+#else
+		return SIMDFloat(std::sqrt(Value.Value));
+#endif
+	}
+	friend SIMDFloat Abs(const SIMDFloat &Value) {
+		return Max(Value, -Value);
+	}
+	/**
+	 * Round the lanes toward negative infinity
+	 */
+	friend SIMDFloat Floor(const SIMDFloat &Value) {
+#if defined(VE_SIMD_AVX2)
+		return SIMDFloat(_mm256_floor_ps(Value.Value));
+#elif defined(VE_SIMD_SSE)
+		// SSE2 has no floor instruction, truncate and fix the negative lanes
+		auto truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(Value.Value));
+		auto fix	   = _mm_and_ps(_mm_cmpgt_ps(truncated, Value.Value), _mm_set1_ps(1.f));
+		return SIMDFloat(_mm_sub_ps(truncated, fix));
+#else
+		return SIMDFloat(std::floor(Value.Value));
+#endif
+	}
+	/**
+	 * The cosine of the lanes, the argument is reduced into [0, pi] and evaluated by a polynomial.
+	 * 2pi is split into a high part exact in float and a low part, so the reduction of the large
+	 * arguments keeps the precision
+	 */
+	friend SIMDFloat Cos(const SIMDFloat &Value) {
+		constexpr float pi		  = 3.14159265358979f;
+		constexpr float twoPi	  = 6.28318530717959f;
+		constexpr float twoPiHigh = 6.28125f;
+		constexpr float twoPiLow  = 0.00193530717959f;
+
+		auto turn	= Floor(Value * Broadcast(1.f / twoPi) + Broadcast(0.5f));
+		auto x		= Abs(Value - turn * Broadcast(twoPiHigh) - turn * Broadcast(twoPiLow));
+		auto flip	= x > Broadcast(pi * 0.5f);
+		x			= Select(flip, Broadcast(pi) - x, x);
+		auto z		= x * x;
+		auto result = Broadcast(1.f) +
+					  z * (Broadcast(-1.f / 2.f) +
+						   z * (Broadcast(1.f / 24.f) +
+								z * (Broadcast(-1.f / 720.f) +
+									 z * (Broadcast(1.f / 40320.f) + z * Broadcast(-1.f / 3628800.f)))));
+		return Select(flip, -result, result);
+	}
+
+public:
+	/**
+	 * Get the value of a lane
+	 * @param Lane The index of the lane
+	 */
+	[[nodiscard]] float Lane(int Lane) const {
+		float lanes[SIMDWidth];
+		Store(lanes);
+		return lanes[Lane];
+	}
+
+public:
+	Register Value;
+};
+
+/**
+ * The 3D vector in SIMD lanes, each lane is an independent vector
+ */
+struct SIMDVec3 {
+	SIMDFloat X;
+	SIMDFloat Y;
+	SIMDFloat Z;
+
+	/**
+	 * Make the lanes with the same vector
+	 * @param Vector The vector of the lanes
+	 */
+	template <class VectorType> static SIMDVec3 Broadcast(const VectorType &Vector) {
+		return {SIMDFloat::Broadcast(Vector.x), SIMDFloat::Broadcast(Vector.y), SIMDFloat::Broadcast(Vector.z)};
+	}
+
+	friend SIMDVec3 operator+(const SIMDVec3 &Left, const SIMDVec3 &Right) {
+		return {Left.X + Right.X, Left.Y + Right.Y, Left.Z + Right.Z};
+	}
+	friend SIMDVec3 operator-(const SIMDVec3 &Left, const SIMDVec3 &Right) {
+		return {Left.X - Right.X, Left.Y - Right.Y, Left.Z - Right.Z};
+	}
+	friend SIMDVec3 operator*(const SIMDVec3 &Left, const SIMDVec3 &Right) {
+		return {Left.X * Right.X, Left.Y * Right.Y, Left.Z * Right.Z};
+	}
+	friend SIMDVec3 operator*(const SIMDVec3 &Left, const SIMDFloat &Right) {
+		return {Left.X * Right, Left.Y * Right, Left.Z * Right};
+	}
+	friend SIMDVec3 operator*(const SIMDFloat &Left, const SIMDVec3 &Right) {
+		return Right * Left;
+	}
+	friend SIMDVec3 operator-(const SIMDVec3 &Value) {
+		return {-Value.X, -Value.Y, -Value.Z};
+	}
+
+	friend SIMDFloat Dot(const SIMDVec3 &Left, const SIMDVec3 &Right) {
+		return Left.X * Right.X + Left.Y * Right.Y + Left.Z * Right.Z;
+	}
+	friend SIMDVec3 Normalize(const SIMDVec3 &Value) {
+		return Value * (SIMDFloat::Broadcast(1.f) / Sqrt(Dot(Value, Value)));
+	}
+	/**
+	 * Reflect the vector by the normal, the same as reflect in SKSL
+	 */
+	friend SIMDVec3 Reflect(const SIMDVec3 &Vector, const SIMDVec3 &Normal) {
+		return Vector - SIMDFloat::Broadcast(2.f) * Dot(Vector, Normal) * Normal;
+	}
+	/**
+	 * Refract the unit vector by the normal and the ratio of the indices of refraction, the same as
+	 * refract in SKSL, the lanes of the total internal reflection are zero
+	 */
+	friend SIMDVec3 Refract(const SIMDVec3 &Vector, const SIMDVec3 &Normal, const SIMDFloat &Ratio) {
+		const auto zero = SIMDFloat::Broadcast(0.f);
+
+		auto cosine = Dot(Normal, Vector);
+		auto k		= SIMDFloat::Broadcast(1.f) - Ratio * Ratio * (SIMDFloat::Broadcast(1.f) - cosine * cosine);
+		auto result = Ratio * Vector - (Ratio * cosine + Sqrt(Max(k, zero))) * Normal;
+
+		return Select(k < zero, SIMDVec3{zero, zero, zero}, result);
+	}
+	friend SIMDVec3 Select(const SIMDMask &Mask, const SIMDVec3 &True, const SIMDVec3 &False) {
+		return {Select(Mask, True.X, False.X), Select(Mask, True.Y, False.Y), Select(Mask, True.Z, False.Z)};
+	}
+};
+} // namespace Vedo
\ No newline at end of file
@@ -49,6 +49,10 @@ using Vec4 = SkV4;
  * The alias of the vector
  */
 using Point = Vec3;
+/**
+ * The 4x4 matrix in vedo render, it transforms the instances.
+ */
+using Matrix = SkM44;
 
 /**
  * The static class provide API for uniform variable converting
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeAdaptive.h
+ * \brief The adaptive sampling of the progressive renders
+ */
+
+#pragma once
+
+#include <include/render/VeCamera.h>
+
+#include <cstdint>
+
+namespace Vedo {
+/**
+ * The adaptive sampling of the progressive renders, the samples are spent on the noisy pixels
+ * instead of every pixel taking the same SPP. The passes of each pixel are tracked in a float
+ * surface beside the accumulated image:
+ *   R : the mean luminance of the passes
+ *   G : the sum of the squared differences of the luminance from the mean, by Welford
+ *   B : the count of the passes blended into the pixel
+ *   A : 1 when the pixel is not sampled any more
+ * A pixel stops when the standard error of its mean luminance is below the threshold relative to
+ * the square root of the luminance, or when it takes MaxScale times the SPP of the camera. The render goes on until
+ * all the pixels stop or the samples reach the budget of SPP samples per pixel, so the samples the
+ * converged pixels do not take are spent on the noisy pixels
+ */
+class AdaptiveSampling {
+public:
+	/**
+	 * The count of the samples a pixel takes before its variance is trusted, the variance of a few
+	 * passes misses the rare bright paths and stops the pixel too early
+	 */
+	static constexpr int MinSample = 64;
+	/**
+	 * A pixel takes at most MaxScale times the SPP of the camera
+	 */
+	static constexpr int MaxScale = 4;
+
+public:
+	/**
+	 * Make the statistics of the image
+	 * @param Width The width of the image
+	 * @param Height The height of the image
+	 * @param Threshold The standard error of a converged pixel relative to the square root of its
+	 * luminance
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @param SampleTarget The SPP of the camera, the budget of the samples per pixel
+	 * @return The adaptive sampling instance, nullptr when the threshold is not positive
+	 */
+	static std::unique_ptr<AdaptiveSampling> Make(int Width, int Height, float Threshold, int SamplePerPass,
+												  int SampleTarget);
+
+public:
+	/**
+	 * Drop the statistics, all the pixels are sampled again
+	 */
+	void Reset();
+	/**
+	 * Detach the snapshots taken before from the statistics, it should be called before the pixels
+	 * of a pass are accumulated
+	 */
+	void Prepare();
+	/**
+	 * Blend the color of a pass into the pixel of the accumulated image by the count of the passes of
+	 * the pixel and update its statistics. It only touches the state of the pixel, so disjoint
+	 * ranges of pixels may be accumulated concurrently, like the tiles of NativeRender, while
+	 * Render::AdaptivePass accumulates the whole pass on one thread
+	 * @param X The x coordinate of the pixel
+	 * @param Y The y coordinate of the pixel
+	 * @param Pixel The RGBA float pixel of the accumulated image
+	 * @param Red The red channel of the pass
+	 * @param Green The green channel of the pass
+	 * @param Blue The blue channel of the pass
+	 */
+	void Accumulate(int X, int Y, float *Pixel, float Red, float Green, float Blue);
+	/**
+	 * Count the samples of the pass and the pixels still sampled, it should be called when all the
+	 * pixels of the pass are accumulated
+	 */
+	void Finish();
+	/**
+	 * Get the snapshot of the statistics, the shader reads the alpha as the mask of the stopped pixels
+	 * @return The snapshot image
+	 */
+	sk_sp<SkImage> Snapshot();
+
+public:
+	/**
+	 * Whether the pixel is still sampled
+	 * @param X The x coordinate of the pixel
+	 * @param Y The y coordinate of the pixel
+	 * @return Whether the pixel is still sampled
+	 */
+	[[nodiscard]] bool Active(int X, int Y) const {
+		return static_cast<const float *>(_pixels.addr(X, Y))[3] == 0.f;
+	}
+	/**
+	 * Whether all the pixels stop or the samples reach the budget
+	 * @return Whether the image has converged
+	 */
+	[[nodiscard]] bool Converged() const {
+		return _remaining == 0 || _sampleCount >= _budget;
+	}
+	/**
+	 * Get the count of the pixels still sampled
+	 * @return The count of the pixels
+	 */
+	[[nodiscard]] int Remaining() const {
+		return _remaining;
+	}
+	/**
+	 * Get the count of the samples taken by all the pixels
+	 * @return The count of the samples
+	 */
+	[[nodiscard]] int64_t SampleCount() const {
+		return _sampleCount;
+	}
+	/**
+	 * Get the count of the samples saved by the converged pixels, the samples they do not take
+	 * below the SPP of the camera
+	 * @return The count of the samples
+	 */
+	[[nodiscard]] int64_t SavedSample() const {
+		return _savedSample;
+	}
+
+private:
+	AdaptiveSampling(sk_sp<SkSurface> Statistics, float Threshold, int SamplePerPass, int SampleTarget);
+
+private:
+	sk_sp<SkSurface> _statistics;
+	SkPixmap		 _pixels;
+
+private:
+	float	_threshold;
+	int		_samplePerPass;
+	int		_sampleTarget;
+	int64_t _budget;
+	int		_remaining;
+	int64_t _sampleCount;
+	int64_t _savedSample;
+};
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,548 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeBVH.h
+ * \brief The bounding volume hierarchy of the Vedo objects
+ */
+
+#pragma once
+
+#include <include/math/VeBound.h>
+#include <include/render/VeMesh.h>
+#include <include/render/VeObject.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <span>
+
+namespace Vedo {
+VeRegisterException(BVHInvalidInstance, R"(Vedo BVH : The instance refers to the invalid object "{}")");
+VeRegisterException(BVHSingularTransform, R"(Vedo BVH : The transform of the instance "{}" is not invertible)");
+
+/**
+ * The node of the BVH, the nodes are stored in depth-first order so the first child of an interior
+ * node is always the next node, and "Escape" is the node right after the subtree. The traversal is
+ * stackless: visit the next node when the ray hits the bound of an interior node, otherwise jump to
+ * "Escape", it ends when the index reaches the count of the nodes. A leaf carries what the shader
+ * needs to shade its hit, the material of its object and the transform of its instance, since the
+ * shader can only look up the other arrays by scanning them
+ */
+class BVHNode : public ShaderStructure<BVHNode> {
+public:
+	static constexpr auto ShaderFields() {
+		return MakeShaderFields(ShaderFieldOf<&BVHNode::BoundMin>("BoundMin"),
+								ShaderFieldOf<&BVHNode::BoundMax>("BoundMax"),
+								ShaderFieldOf<&BVHNode::Escape>("Escape"),
+								ShaderFieldOf<&BVHNode::Object>("Object"),
+								ShaderFieldOf<&BVHNode::Triangle>("Triangle"),
+								ShaderFieldOf<&BVHNode::Instance>("Instance"),
+								ShaderFieldOf<&BVHNode::Material>("Material"),
+								ShaderFieldOf<&BVHNode::Root>("Root"),
+								ShaderFieldOf<&BVHNode::Translation>("Translation"),
+								ShaderFieldOf<&BVHNode::InverseX>("InverseX"),
+								ShaderFieldOf<&BVHNode::InverseY>("InverseY"),
+								ShaderFieldOf<&BVHNode::InverseZ>("InverseZ"));
+	}
+	[[nodiscard]] std::string Type() const override {
+		return "BVHNode";
+	}
+
+public:
+	Vec3 BoundMin;
+	Vec3 BoundMax;
+	/**
+	 * The index of the node after the subtree of this node
+	 */
+	int Escape;
+	/**
+	 * The index of the object in the leaf, -1 for the interior node
+	 */
+	int Object;
+	/**
+	 * The triangle in the leaf of a mesh object, numbered through the meshes of all the objects like
+	 * Vedo::MeshBuffer, -1 for the sphere and the interior node
+	 */
+	int Triangle;
+	/**
+	 * The instance in the leaf of the top level BVH, -1 for the other nodes. "Object" of the leaf is
+	 * the prototype of the instance
+	 */
+	int Instance;
+	/**
+	 * The material of the object in the leaf, the prototype for an instance leaf, -1 for the interior
+	 * node
+	 */
+	int Material;
+	/**
+	 * The copy of InstanceNode::Root and the transform of the instance in the instance leaf, -1 and
+	 * zero for the other nodes
+	 */
+	int	 Root;
+	Vec3 Translation;
+	Vec3 InverseX;
+	Vec3 InverseY;
+	Vec3 InverseZ;
+};
+
+/**
+ * The instance of the two level BVH. The ray is moved into the space of the prototype by the inverse
+ * of the transform, then the bottom level BVH of the prototype is walked as it is. The shader reads
+ * the copy of the instance in its leaf of the top level BVH
+ */
+class InstanceNode : public ShaderStructure<InstanceNode> {
+public:
+	static constexpr auto ShaderFields() {
+		return MakeShaderFields(ShaderFieldOf<&InstanceNode::Object>("Object"),
+								ShaderFieldOf<&InstanceNode::Root>("Root"),
+								ShaderFieldOf<&InstanceNode::Translation>("Translation"),
+								ShaderFieldOf<&InstanceNode::InverseX>("InverseX"),
+								ShaderFieldOf<&InstanceNode::InverseY>("InverseY"),
+								ShaderFieldOf<&InstanceNode::InverseZ>("InverseZ"));
+	}
+	[[nodiscard]] std::string Type() const override {
+		return "InstanceNode";
+	}
+
+public:
+	/**
+	 * The index of the prototype object
+	 */
+	int Object;
+	/**
+	 * The root of the bottom level BVH of the prototype in BVH::BottomNodes, the bottom level BVH
+	 * ends at the "Escape" of the root
+	 */
+	int Root;
+	/**
+	 * The translation of the transform
+	 */
+	Vec3 Translation;
+	/**
+	 * The rows of the inverse of the linear part of the transform, the ray is moved into the space of
+	 * the prototype by them, and their transpose moves the normal back to the world
+	 */
+	Vec3 InverseX;
+	Vec3 InverseY;
+	Vec3 InverseZ;
+};
+
+/**
+ * The BVH over the bounds of the objects, built by binned SAH. Every leaf holds exactly one primitive,
+ * a sphere or a triangle of a mesh, so the shader can take the sphere directly from the bound of the
+ * leaf and the meshes never count as one huge primitive. A subtree of N primitives always has
+ * 2N - 1 nodes, so the nodes are allocated once for the whole tree and every subtree writes its own
+ * slice of them, which lets the subtrees be built by different threads
+ */
+class BVH {
+public:
+	/**
+	 * The count of the texels of a node in the node shader, the bounds with the escape and the object
+	 * come first, then the leaf references and the transform of the instance. It is the same as the
+	 * constant in path_tracing.sksl
+	 */
+	static constexpr int NodeTexelCount = 6;
+
+public:
+	/**
+	 * Build the BVH of the objects on the calling thread
+	 * @param Objects The objects of the scene, the leaves refer to them by their index
+	 * @param BinCount The count of the bins on each axis used to evaluate the SAH
+	 * @return The BVH instance
+	 */
+	static std::unique_ptr<BVH> Make(const std::vector<Object *> &Objects, int BinCount = 16);
+	/**
+	 * Build the BVH of the objects by a thread pool. The top levels are split by binning the
+	 * primitives in chunks, each thread fills its own histogram which are merged afterward, the
+	 * subtrees below are built as parallel tasks
+	 * @param Objects The objects of the scene, the leaves refer to them by their index
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @param BinCount The count of the bins on each axis used to evaluate the SAH
+	 * @return The BVH instance
+	 */
+	static std::unique_ptr<BVH> MakeParallel(const std::vector<Object *> &Objects, int ThreadCount = 0,
+											 int BinCount = 16);
+	/**
+	 * Build the BVH of the objects stored contiguously by a thread pool
+	 * @param Objects The objects of the scene, the leaves refer to them by their index
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @param BinCount The count of the bins on each axis used to evaluate the SAH
+	 * @return The BVH instance
+	 */
+	static std::unique_ptr<BVH> MakeParallel(std::span<const Object> Objects, int ThreadCount = 0,
+											 int BinCount = 16);
+	/**
+	 * Make the BVH of the nodes built before, like the nodes loaded from a scene file, the nodes should
+	 * be laid out by the builder. The tree is taken as it is without building it again
+	 * @param Nodes The nodes in depth-first order
+	 * @return The BVH instance
+	 */
+	static std::unique_ptr<BVH> MakeFromNodes(std::vector<BVHNode> Nodes);
+	/**
+	 * Build the two level BVH of the objects and the instances. Each prototype, the object referred by
+	 * any instance, gets its own bottom level BVH over its geometry, which are stored one after another
+	 * in BottomNodes(). The top level BVH in Nodes() is built over the instances and the other objects,
+	 * its instance leaves refer to InstanceNodes(). The prototypes are only drawn by their instances
+	 * @param Objects The objects of the scene, the prototypes included
+	 * @param Instances The instances of the prototypes
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @param BinCount The count of the bins on each axis used to evaluate the SAH
+	 * @return The BVH instance
+	 */
+	static std::unique_ptr<BVH> MakeInstanced(const std::vector<Object *> &Objects,
+											  const std::vector<Instance *> &Instances, int ThreadCount = 0,
+											  int BinCount = 16);
+	/**
+	 * Get the bound of an object, the bound of a mesh object contains all its triangles
+	 * @param Target The object
+	 * @return The bound of the object
+	 */
+	static Bound ObjectBound(const Object &Target);
+	/**
+	 * Get the count of the triangles of an object, 0 for the objects not in MeshGeometry shape
+	 * @param Target The object
+	 * @return The count of the triangles
+	 */
+	static size_t TriangleCount(const Object &Target);
+
+public:
+	/**
+	 * Get the nodes in depth-first order
+	 * @return The nodes
+	 */
+	[[nodiscard]] const std::vector<BVHNode> &Nodes() const {
+		return _nodes;
+	}
+	/**
+	 * Make the child shader of the nodes, which should be bound to "u_bvh" by Shader::BindChild.
+	 * Each node takes NodeTexelCount texels, the shader fetches the node it walks to directly. It
+	 * should be made again after the BVH is updated
+	 * @return The Skia shader instance
+	 */
+	[[nodiscard]] sk_sp<SkShader> MakeNodeShader() const;
+	/**
+	 * Get the bound of the steps of the walk, which should be bound to the link variable
+	 * "u_NodeLimit" by Shader::BindUniform. Each step moves forward, so the walk takes at most the
+	 * count of the nodes. It is rounded up to a power of two, so the shader is not compiled again
+	 * on every change of the count
+	 * @return The bound of the steps
+	 */
+	[[nodiscard]] int NodeLimit() const;
+	/**
+	 * Get the bottom level BVHs of the prototypes, empty without instances
+	 * @return The nodes of the bottom level BVHs
+	 */
+	[[nodiscard]] const std::vector<BVHNode> &BottomNodes() const {
+		return _bottomNodes;
+	}
+	/**
+	 * Get the instances read by the top level BVH, empty without instances
+	 * @return The instances
+	 */
+	[[nodiscard]] const std::vector<InstanceNode> &InstanceNodes() const {
+		return _instanceNodes;
+	}
+	/**
+	 * Make the child shader of the bottom level nodes in the same layout as MakeNodeShader, which
+	 * should be bound to "u_blas" by Shader::BindChild. It is the empty shader without instances
+	 * @return The Skia shader instance
+	 */
+	[[nodiscard]] sk_sp<SkShader> MakeBottomNodeShader() const;
+	/**
+	 * Get the bound of the steps of the walk in a bottom level BVH, which should be bound to the link
+	 * variable "u_BottomNodeLimit" by Shader::BindUniform. The walk of an instance only visits the
+	 * nodes of its prototype, so it is the node count of the largest prototype rounded up to a power
+	 * of two
+	 * @return The bound of the steps
+	 */
+	[[nodiscard]] int BottomNodeLimit() const;
+	/**
+	 * Get the time spent by the last build
+	 * @return The build time in milliseconds
+	 */
+	[[nodiscard]] double BuildTime() const {
+		return _buildTime;
+	}
+	/**
+	 * Get the SAH cost of the tree, the sum of the areas of the nodes relative to the root, it
+	 * measures the count of the nodes a random ray is expected to visit
+	 * @return The SAH cost of the tree
+	 */
+	[[nodiscard]] float Cost() const;
+
+public:
+	/**
+	 * Recompute the bounds of the nodes bottom-up from the objects in O(n), the topology of the tree
+	 * is kept, so it only suits the objects and the vertices moved slightly
+	 * @param Objects The objects the BVH is built with, in the same order
+	 */
+	void Refit(const std::vector<Object *> &Objects);
+	/**
+	 * Update the BVH for the moved objects, it refits the tree and only rebuilds it when the SAH
+	 * cost has grown past the threshold of the cost after the last build, or when the count of the
+	 * primitives is changed. The node shader should be made again after it. The BVH made by
+	 * MakeInstanced is updated by the overload with the instances
+	 * @param Objects The objects the BVH is built with, in the same order
+	 * @param RebuildThreshold The ratio of the cost to the cost of the last build that triggers
+	 * a rebuild
+	 * @return Whether the BVH is rebuilt
+	 */
+	bool Update(const std::vector<Object *> &Objects, float RebuildThreshold = 1.5f);
+	/**
+	 * Update the two level BVH for the moved instances and objects. Only the top level BVH is built
+	 * again, it is small, while the bottom level BVHs are kept, so the prototypes should not be changed.
+	 * The node shader should be made again after it, the bottom level node shader is kept
+	 * @param Objects The objects the BVH is built with, in the same order
+	 * @param Instances The instances the BVH is built with, in the same order
+	 */
+	void Update(const std::vector<Object *> &Objects, const std::vector<Instance *> &Instances);
+
+private:
+	BVH() = default;
+
+private:
+	/**
+	 * The primitive referred by the builder
+	 */
+	struct Primitive {
+		Bound Box;
+		Vec3  Centroid;
+		int	  Object;
+		int	  Triangle;
+		int	  Instance;
+		int	  Material;
+	};
+	/**
+	 * The bin of the SAH histogram
+	 */
+	struct Bin {
+		Bound Box	= Bound::Empty();
+		int	  Count = 0;
+	};
+	/**
+	 * The bins of the three axes, the bins of an axis are stored contiguously
+	 */
+	using Histogram = std::vector<Bin>;
+	/**
+	 * The state shared by the build tasks
+	 */
+	struct Builder {
+		std::vector<Primitive> Primitives;
+		int					   BinCount;
+		int					   ChunkCount;
+
+		std::atomic<int>		Pending;
+		std::mutex				Lock;
+		std::condition_variable Finished;
+
+		/**
+		 * The pool running the tasks, the pool of the build or the one shared by several builds
+		 */
+		SkExecutor *Executor = nullptr;
+		/**
+		 * Declared last, so the worker threads are joined before the lock is destroyed
+		 */
+		std::unique_ptr<SkExecutor> OwnedExecutor;
+	};
+
+private:
+	/**
+	 * Make the primitives of the objects, a mesh object makes a primitive for each triangle
+	 * @param Objects The list of the objects or the pointers to the objects
+	 * @param Prototypes Whether each object is a prototype, which makes no primitive but still numbers
+	 * its triangles. Empty when there is no prototype
+	 * @return The primitives, they refer to the objects by the index in the list
+	 */
+	template <class ObjectList>
+	static std::vector<Primitive> MakePrimitives(const ObjectList &Objects,
+												 const std::vector<bool> &Prototypes = {}) {
+		auto objectOf = [&](size_t Index) -> const Object & {
+			if constexpr (std::is_pointer_v<typename ObjectList::value_type>) {
+				return *Objects[Index];
+			} else {
+				return Objects[Index];
+			}
+		};
+
+		auto prototype = [&](size_t Index) { return !Prototypes.empty() && Prototypes[Index]; };
+
+		size_t count = 0;
+		for (size_t index = 0; index < Objects.size(); ++index) {
+			if (!prototype(index)) {
+				count += objectOf(index).Shape == MeshGeometry ? TriangleCount(objectOf(index)) : 1;
+			}
+		}
+
+		// The triangles are numbered through the meshes in the order of the objects
+		std::vector<Primitive> primitives;
+		primitives.reserve(count);
+		int triangleBase = 0;
+		for (size_t index = 0; index < Objects.size(); ++index) {
+			auto &target		= objectOf(index);
+			auto  triangleCount = static_cast<int>(TriangleCount(target));
+			if (prototype(index)) {
+				triangleBase += triangleCount;
+
+				continue;
+			}
+			if (target.Shape != MeshGeometry) {
+				auto bound = ObjectBound(target);
+				primitives.push_back(
+					{bound, bound.Centroid(), static_cast<int>(index), -1, -1, target.Material});
+
+				continue;
+			}
+
+			for (int triangle = 0; triangle < triangleCount; ++triangle) {
+				auto bound = target.Geometry->TriangleBound(triangle);
+				primitives.push_back({bound, bound.Centroid(), static_cast<int>(index),
+									  triangleBase + triangle, -1, target.Material});
+			}
+			triangleBase += triangleCount;
+		}
+
+		return primitives;
+	}
+	/**
+	 * Pack the nodes into the texture shader, NodeTexelCount texels each
+	 * @param Nodes The nodes in depth-first order
+	 * @return The Skia shader instance
+	 */
+	static sk_sp<SkShader> MakeNodeShader(const std::vector<BVHNode> &Nodes);
+	/**
+	 * Build the BVH of the primitives
+	 * @param Primitives The primitives of the objects
+	 * @param BinCount The count of the bins on each axis
+	 * @param ThreadCount The count of the worker threads, 1 to build on the calling thread
+	 * @param Executor The thread pool shared by several builds, null to make a pool for this build
+	 * when ThreadCount is not 1
+	 * @return The BVH instance
+	 */
+	static std::unique_ptr<BVH> Make(std::vector<Primitive> Primitives, int BinCount, int ThreadCount,
+									 SkExecutor *Executor = nullptr);
+	/**
+	 * Make the thread pool of a build
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @return The thread pool, null when ThreadCount is 1
+	 */
+	static std::unique_ptr<SkExecutor> MakeExecutor(int ThreadCount);
+	/**
+	 * Make the primitives of the top level BVH, the objects except the prototypes and the instances
+	 * @param Objects The objects of the scene
+	 * @param Instances The instances of the prototypes
+	 * @return The primitives
+	 */
+	std::vector<Primitive> MakeTopPrimitives(const std::vector<Object *> &Objects,
+											 const std::vector<Instance *> &Instances) const;
+	/**
+	 * Make the instance read by the shader, it will throw a BVHSingularTransform exception when the
+	 * transform can not be inverted
+	 * @param Target The instance
+	 * @param Index The index of the instance
+	 * @return The instance node
+	 */
+	InstanceNode MakeInstanceNode(const Instance &Target, int Index) const;
+
+private:
+	/**
+	 * Build the top levels on the calling thread, the primitives are binned in parallel chunks until
+	 * the subtree is small enough to be built by a single task
+	 * @param Context The builder
+	 * @param Begin The first primitive of the subtree
+	 * @param End The end of the primitives of the subtree
+	 * @param Node The index of the root node of the subtree
+	 */
+	void BuildTop(Builder &Context, int Begin, int End, int Node);
+	/**
+	 * Build the subtree of the primitives in [Begin, End) into the nodes from Node
+	 * @param Context The builder
+	 * @param Begin The first primitive of the subtree
+	 * @param End The end of the primitives of the subtree
+	 * @param Node The index of the root node of the subtree
+	 */
+	void BuildSubtree(Builder &Context, int Begin, int End, int Node);
+	/**
+	 * Run the task by the thread pool of the builder, or on the calling thread without the pool
+	 * @param Context The builder
+	 * @param Task The task to be run
+	 */
+	static void Spawn(Builder &Context, std::function<void()> Task);
+	/**
+	 * Write the node of the subtree
+	 * @param Context The builder
+	 * @param Begin The first primitive of the subtree
+	 * @param End The end of the primitives of the subtree
+	 * @param Node The index of the node
+	 * @param Box The bound of the primitives
+	 * @return Whether the node is a leaf
+	 */
+	bool WriteNode(const Builder &Context, int Begin, int End, int Node, const Bound &Box);
+	/**
+	 * Measure the bound and the bound of the centroids of the primitives
+	 * @param Context The builder
+	 * @param Begin The first primitive
+	 * @param End The end of the primitives
+	 * @param Box The bound to be expanded
+	 * @param CentroidBound The bound of the centroids to be expanded
+	 */
+	static void Measure(const Builder &Context, int Begin, int End, Bound &Box, Bound &CentroidBound);
+	/**
+	 * Fill the primitives into the histogram
+	 * @param Context The builder
+	 * @param Begin The first primitive
+	 * @param End The end of the primitives
+	 * @param CentroidBound The bound of the centroids of all the primitives of the subtree
+	 * @param Bins The histogram to be filled
+	 */
+	static void Fill(const Builder &Context, int Begin, int End, const Bound &CentroidBound, Histogram &Bins);
+	/**
+	 * Partition the primitives in [Begin, End) by the split with the lowest SAH cost in the histogram
+	 * @param Context The builder
+	 * @param Begin The first primitive
+	 * @param End The end of the primitives
+	 * @param CentroidBound The bound of the centroids of the primitives
+	 * @param Bins The histogram of the primitives
+	 * @return The first primitive of the right side
+	 */
+	static int Partition(Builder &Context, int Begin, int End, const Bound &CentroidBound,
+						 const Histogram &Bins);
+
+private:
+	std::vector<BVHNode> _nodes;
+	double				 _buildTime = 0;
+	float				 _buildCost = 0;
+
+private:
+	std::vector<BVHNode>	  _bottomNodes;
+	std::vector<InstanceNode> _instanceNodes;
+	/**
+	 * The root of the bottom level BVH of each object, -1 for the objects not instanced
+	 */
+	std::vector<int> _roots;
+
+private:
+	int _binCount	 = 16;
+	int _threadCount = 1;
+};
+} // namespace Vedo
\ No newline at end of file
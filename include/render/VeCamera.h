@@ -28,13 +28,14 @@
 #pragma once
 
 #include <include/math/VeVector.h>
-#include <include/shader/VeShader.h>
+#include <include/render/VeSampler.h>
+#include <include/shader/VeShaderStructure.h>
 
 namespace Vedo {
 /**
  * The camera of the Vedo Render
  */
-class Camera : public Vedo::IShaderStructureUniform {
+class Camera : public ShaderStructure<Camera> {
 public:
 	Camera();
 
@@ -45,32 +46,22 @@ public:
 	void Init();
 
 public:
-	std::vector<std::string> PropertyList() override {
-		return {"Ratio", "Width", "SPP", "Depth", "LookFrom", "LookAt", "VUP", "FOV", "FocusDistance", "DeFocusAngle", "Height", "Center", "PixelDeltaU", "PixelDeltaV", "Pixel100Loc", "U", "V", "W", "DeFocusDiskU", "DeFocusDiskV"};
-	}
-	std::map<std::string, std::string> PropertyValue() override {
-		return {
-			{ "Ratio", std::to_string(Ratio) },
-			{ "Width", std::to_string(Width) },
-			{ "SPP", std::to_string(SPP) },
-			{ "Depth", std::to_string(Depth) },
-			{ "LookFrom", Vedo::MathUniform::UniformVec3(LookFrom) },
-			{ "LookAt", Vedo::MathUniform::UniformVec3(LookAt) },
-			{ "VUP", Vedo::MathUniform::UniformVec3(VUP) },
-			{ "FOV", std::to_string(FOV) },
-			{ "FocusDistance", std::to_string(FocusDistance) },
-			{ "DeFocusAngle", std::to_string(DeFocusAngle) },
-			{ "Height", std::to_string(Height) },
-			{ "Center", Vedo::MathUniform::UniformVec3(Center) },
-			{ "PixelDeltaU", Vedo::MathUniform::UniformVec3(PixelDeltaU) },
-			{ "PixelDeltaV", Vedo::MathUniform::UniformVec3(PixelDeltaV) },
-			{ "Pixel100Loc", Vedo::MathUniform::UniformVec3(Pixel100Loc) },
-			{ "U", Vedo::MathUniform::UniformVec3(U) },
-			{ "V", Vedo::MathUniform::UniformVec3(V) },
-			{ "W", Vedo::MathUniform::UniformVec3(W) },
-			{ "DeFocusDiskU", Vedo::MathUniform::UniformVec3(DeFocusDiskU) },
-			{ "DeFocusDiskV", Vedo::MathUniform::UniformVec3(DeFocusDiskV) }
-		};
+	static constexpr auto ShaderFields() {
+		return MakeShaderFields(
+			ShaderFieldOf<&Camera::Ratio>("Ratio"), ShaderFieldOf<&Camera::Width>("Width"),
+			ShaderFieldOf<&Camera::SPP>("SPP"), ShaderFieldOf<&Camera::Depth>("Depth"),
+			ShaderFieldOf<&Camera::Sampler>("Sampler"), ShaderFieldOf<&Camera::RouletteDepth>("RouletteDepth"),
+			ShaderFieldOf<&Camera::AdaptiveThreshold>("AdaptiveThreshold"),
+			ShaderFieldOf<&Camera::LookFrom>("LookFrom"), ShaderFieldOf<&Camera::LookAt>("LookAt"),
+			ShaderFieldOf<&Camera::VUP>("VUP"), ShaderFieldOf<&Camera::FOV>("FOV"),
+			ShaderFieldOf<&Camera::FocusDistance>("FocusDistance"),
+			ShaderFieldOf<&Camera::DeFocusAngle>("DeFocusAngle"), ShaderFieldOf<&Camera::Height>("Height"),
+			ShaderFieldOf<&Camera::Center>("Center"), ShaderFieldOf<&Camera::PixelDeltaU>("PixelDeltaU"),
+			ShaderFieldOf<&Camera::PixelDeltaV>("PixelDeltaV"),
+			ShaderFieldOf<&Camera::Pixel100Loc>("Pixel100Loc"), ShaderFieldOf<&Camera::U>("U"),
+			ShaderFieldOf<&Camera::V>("V"), ShaderFieldOf<&Camera::W>("W"),
+			ShaderFieldOf<&Camera::DeFocusDiskU>("DeFocusDiskU"),
+			ShaderFieldOf<&Camera::DeFocusDiskV>("DeFocusDiskV"));
 	}
 	[[nodiscard]] std::string Type() const override {
 		return "Camera";
@@ -81,6 +72,23 @@ public:
 	float Width;
 	float SPP;
 	float Depth;
+	/**
+	 * The sampler of the pixel offsets, the defocus disk and the bounces, RandomSampler or
+	 * SobolSampler
+	 */
+	float Sampler = RandomSampler;
+	/**
+	 * The count of the bounces before the Russian roulette, after them a path goes on with the
+	 * probability of its throughput, so the dark paths stop early. No path is stopped by the
+	 * roulette when it is not less than Depth
+	 */
+	float RouletteDepth = 3;
+	/**
+	 * The standard error of a converged pixel relative to the square root of its luminance, the
+	 * converged pixels are not sampled any more and their samples are spent on the noisy pixels. 0 turns
+	 * the adaptive sampling off, so every pixel takes SPP samples
+	 */
+	float AdaptiveThreshold = 0;
 
 	Point LookFrom;
 	Point LookAt;
@@ -107,5 +115,6 @@ private:
 
 public:
 	friend class Render;
+	friend class NativeRender;
 };
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeMaterial.h
+ * \brief The material table of the Vedo renderer
+ */
+
+#pragma once
+
+#include <include/math/VeVector.h>
+#include <include/shader/VeShaderStructure.h>
+
+#include <map>
+#include <tuple>
+
+namespace Vedo {
+VeRegisterException(MaterialOutOfRange, R"(Vedo Material : The material {} is not in the table)");
+
+constexpr int LambertMaterial	 = 0;
+constexpr int MetalMaterial		 = 1;
+constexpr int DielectricMaterial = 2;
+
+/**
+ * The material of the objects, the objects refer to it by its index in the material table
+ */
+class Material : public ShaderStructure<Material> {
+public:
+	static constexpr auto ShaderFields() {
+		return MakeShaderFields(ShaderFieldOf<&Material::Kind>("Kind"), ShaderFieldOf<&Material::Albedo>("Albedo"),
+								ShaderFieldOf<&Material::Fuzz>("Fuzz"),
+								ShaderFieldOf<&Material::IndexRefraction>("IndexRefraction"));
+	}
+	[[nodiscard]] std::string Type() const override {
+		return "Material";
+	}
+
+public:
+	/**
+	 * The kind of the material, one of LambertMaterial, MetalMaterial and DielectricMaterial
+	 */
+	int	  Kind			  = LambertMaterial;
+	Vec3  Albedo		  = {0.f, 0.f, 0.f};
+	float Fuzz			  = 0.f;
+	float IndexRefraction = 1.f;
+};
+
+/**
+ * The deduplicated materials of a scene. The same material added twice is stored once, so the
+ * objects sharing it refer to one record and a change of it is made once for all of them
+ */
+class MaterialTable {
+public:
+	/**
+	 * Add a material into the table, the index of the equal material is returned if it has been added
+	 * @param Value The material to be added
+	 * @return The index of the material
+	 */
+	int Add(const Material &Value);
+	/**
+	 * Change the material of an index, every object referring to it takes the new material. It will
+	 * throw a MaterialOutOfRange exception when the index is not in the table
+	 * @param Index The index of the material
+	 * @param Value The new material
+	 */
+	void Set(int Index, const Material &Value);
+
+public:
+	/**
+	 * Get the material of an index, the index should be in the table
+	 */
+	[[nodiscard]] const Material &operator[](int Index) const {
+		return _materials[Index];
+	}
+	/**
+	 * Get the count of the materials
+	 */
+	[[nodiscard]] int Size() const {
+		return static_cast<int>(_materials.size());
+	}
+	/**
+	 * Get the materials in the order of their indices
+	 */
+	[[nodiscard]] const std::vector<Material> &Materials() const {
+		return _materials;
+	}
+	/**
+	 * Get the uniforms of the materials for the u_material array of the shader, the pointers stay
+	 * valid until a material is added
+	 * @return The pointers to the materials in the order of their indices
+	 */
+	std::vector<Material *> Uniforms();
+
+private:
+	using Key = std::tuple<int, float, float, float, float, float>;
+
+	static Key MakeKey(const Material &Value);
+
+private:
+	std::vector<Material> _materials;
+	std::map<Key, int>	  _index;
+};
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeMesh.h
+ * \brief The triangle mesh of the Vedo objects
+ */
+
+#pragma once
+
+#include <include/VeBase.h>
+#include <include/math/VeBound.h>
+#include <include/render/VeObject.h>
+
+#include <array>
+#include <optional>
+#include <span>
+
+namespace Vedo {
+VeRegisterException(MeshInvalidIndex, "Vedo Mesh : The vertex index {} is out of range");
+VeRegisterException(MeshInvalidIndexCount, "Vedo Mesh : The index count {} is not a multiple of 3");
+VeRegisterException(MeshInvalidVertexCount, "Vedo Mesh : The coordinates of {} vertices differ in length");
+
+/**
+ * The triangle mesh, the positions of the vertices are stored as structure-of-arrays and every
+ * three 32-bit indices make a triangle, so the vertices are shared by the triangles around them.
+ * The positions are in world space, an object refers to the mesh by Object::Geometry with
+ * Object::Shape set to MeshGeometry
+ */
+class Mesh {
+public:
+	/**
+	 * Make the mesh of the vertices and the triangles, it will throw a MeshInvalidIndex exception
+	 * when an index is out of the vertices, or a MeshInvalidIndexCount exception when the indices do
+	 * not make whole triangles
+	 * @param Vertices The positions of the vertices
+	 * @param Indices The vertex indices of the triangles, three for each triangle
+	 * @return The mesh instance
+	 */
+	static std::unique_ptr<Mesh> Make(const std::vector<Vec3> &Vertices = {},
+									  const std::vector<uint32_t> &Indices = {});
+	/**
+	 * Make the mesh viewing the buffers owned by others without copying them, like the buffers
+	 * mapped from a scene file. The buffers should outlive the mesh, the mesh copies the buffers into
+	 * its own storage when it is modified. The buffers are checked once, it will throw a
+	 * MeshInvalidVertexCount exception when the coordinate buffers differ in length, a
+	 * MeshInvalidIndex exception when an index is out of the vertices, or a MeshInvalidIndexCount
+	 * exception when the indices do not make whole triangles
+	 * @param X The x coordinates of the vertices
+	 * @param Y The y coordinates of the vertices
+	 * @param Z The z coordinates of the vertices
+	 * @param Indices The vertex indices of the triangles, three for each triangle
+	 * @return The mesh instance
+	 */
+	static std::unique_ptr<Mesh> MakeView(std::span<const float> X, std::span<const float> Y,
+										  std::span<const float> Z, std::span<const uint32_t> Indices);
+
+public:
+	/**
+	 * The views point into the storage of the mesh, so a copy would read the storage of its source
+	 */
+	Mesh(const Mesh &)			  = delete;
+	Mesh &operator=(const Mesh &) = delete;
+
+public:
+	/**
+	 * Append a vertex to the mesh
+	 * @param Position The position of the vertex
+	 * @return The index of the vertex
+	 */
+	uint32_t AddVertex(const Vec3 &Position);
+	/**
+	 * Append a triangle to the mesh, the front face is the one where the vertices are counter-clockwise,
+	 * it will throw a MeshInvalidIndex exception when an index is out of the vertices
+	 * @param First The index of the first vertex
+	 * @param Second The index of the second vertex
+	 * @param Third The index of the third vertex
+	 */
+	void AddTriangle(uint32_t First, uint32_t Second, uint32_t Third);
+	/**
+	 * Move a vertex, the BVH built with the mesh should be updated by BVH::Update afterward, it will
+	 * throw a MeshInvalidIndex exception when the index is out of the vertices
+	 * @param Index The index of the vertex
+	 * @param Position The new position of the vertex
+	 */
+	void SetVertex(uint32_t Index, const Vec3 &Position);
+
+public:
+	[[nodiscard]] size_t VertexCount() const {
+		return _viewX.size();
+	}
+	[[nodiscard]] size_t TriangleCount() const {
+		return _viewIndices.size() / 3;
+	}
+	/**
+	 * Get the position of the vertex
+	 * @param Index The index of the vertex
+	 * @return The position of the vertex
+	 */
+	[[nodiscard]] Vec3 Vertex(uint32_t Index) const {
+		return {_viewX[Index], _viewY[Index], _viewZ[Index]};
+	}
+	/**
+	 * Get the positions of the three vertices of the triangle
+	 * @param Index The index of the triangle
+	 * @return The positions of the vertices
+	 */
+	[[nodiscard]] std::array<Vec3, 3> Triangle(size_t Index) const {
+		return {Vertex(_viewIndices[Index * 3]), Vertex(_viewIndices[Index * 3 + 1]),
+				Vertex(_viewIndices[Index * 3 + 2])};
+	}
+	/**
+	 * Get the bound of the triangle
+	 * @param Index The index of the triangle
+	 * @return The bound of the triangle
+	 */
+	[[nodiscard]] Bound TriangleBound(size_t Index) const;
+	/**
+	 * Get the bound of all the triangles
+	 */
+	[[nodiscard]] Bound MeshBound() const;
+	/**
+	 * Intersect the ray with the triangle by the watertight test, a ray through an edge or a vertex
+	 * shared by the triangles always hits one of them, so there is no crack between the triangles
+	 * @param Index The index of the triangle
+	 * @param Origin The origin of the ray
+	 * @param Direction The direction of the ray, not necessarily normalized
+	 * @param TMin The minimal distance of the hit in the length of the direction
+	 * @param TMax The maximal distance of the hit in the length of the direction
+	 * @return The distance of the hit, none when the ray misses
+	 */
+	[[nodiscard]] std::optional<float> Intersect(size_t Index, const Vec3 &Origin, const Vec3 &Direction,
+												 float TMin, float TMax) const;
+
+public:
+	[[nodiscard]] std::span<const float> X() const {
+		return _viewX;
+	}
+	[[nodiscard]] std::span<const float> Y() const {
+		return _viewY;
+	}
+	[[nodiscard]] std::span<const float> Z() const {
+		return _viewZ;
+	}
+	[[nodiscard]] std::span<const uint32_t> Indices() const {
+		return _viewIndices;
+	}
+
+private:
+	Mesh() = default;
+
+	friend class ObjLoader;
+
+private:
+	/**
+	 * Copy the viewed buffers into the storage of the mesh before modifying them
+	 */
+	void Own();
+	/**
+	 * Point the views to the storage of the mesh, it should be called after the storage is changed
+	 */
+	void ViewStorage();
+
+private:
+	std::vector<float>	  _x;
+	std::vector<float>	  _y;
+	std::vector<float>	  _z;
+	std::vector<uint32_t> _indices;
+	bool				  _owned = true;
+
+	/**
+	 * The buffers read by the mesh, either the storage of the mesh or the buffers of others
+	 */
+	std::span<const float>	  _viewX;
+	std::span<const float>	  _viewY;
+	std::span<const float>	  _viewZ;
+	std::span<const uint32_t> _viewIndices;
+};
+
+/**
+ * The meshes of the scene packed into the shared buffers for the shader. The triangles of the mesh
+ * objects are numbered through all the objects in order, which is the number that the BVH leaves
+ * refer to, and the indices are offset to the shared vertex buffer. SKSL can not index an array by
+ * a variable, so the buffers are passed as float textures sampled by the child shaders, each texel
+ * holds a vertex position or the three indices of a triangle
+ */
+class MeshBuffer {
+public:
+	/**
+	 * The width of the buffer textures, the texel of the element "i" is (i % width, i / width). It
+	 * is the same as the constant in path_tracing.sksl
+	 */
+	static constexpr int TextureWidth = 1024;
+
+public:
+	/**
+	 * Pack the meshes of the objects, the objects of other shapes are skipped
+	 * @param Objects The objects of the scene in the same order as the BVH is built with
+	 * @return The mesh buffer instance
+	 */
+	static std::unique_ptr<MeshBuffer> Make(const std::vector<Object *> &Objects);
+
+public:
+	/**
+	 * Make the child shader of the vertex buffer, which should be bound to "u_vertex" by
+	 * Shader::BindChild
+	 * @return The Skia shader instance
+	 */
+	[[nodiscard]] sk_sp<SkShader> MakeVertexShader() const;
+	/**
+	 * Make the child shader of the index buffer, which should be bound to "u_index" by
+	 * Shader::BindChild. The indices are stored as floats, so they are exact up to 2^24 vertices
+	 * @return The Skia shader instance
+	 */
+	[[nodiscard]] sk_sp<SkShader> MakeIndexShader() const;
+	/**
+	 * Make the texture shader of the elements with four floats each, the element "i" is read by
+	 * BufferCoord(i) in path_tracing.sksl. The BVH packs its nodes by it as well
+	 * @param Texels The elements
+	 * @param Count The count of the elements
+	 * @return The Skia shader instance, the empty shader when there is no element
+	 */
+	static sk_sp<SkShader> MakeTextureShader(const std::vector<float> &Texels, size_t Count);
+
+public:
+	[[nodiscard]] size_t VertexCount() const {
+		return _x.size();
+	}
+	[[nodiscard]] size_t TriangleCount() const {
+		return _indices.size() / 3;
+	}
+	[[nodiscard]] const std::vector<float> &X() const {
+		return _x;
+	}
+	[[nodiscard]] const std::vector<float> &Y() const {
+		return _y;
+	}
+	[[nodiscard]] const std::vector<float> &Z() const {
+		return _z;
+	}
+	[[nodiscard]] const std::vector<uint32_t> &Indices() const {
+		return _indices;
+	}
+
+private:
+	MeshBuffer() = default;
+
+private:
+	std::vector<float>	  _x;
+	std::vector<float>	  _y;
+	std::vector<float>	  _z;
+	std::vector<uint32_t> _indices;
+};
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeNativeRender.h
+ * \brief The native CPU render of Vedo
+ */
+
+#pragma once
+
+#include <include/math/VeRandom.h>
+#include <include/math/VeSIMD.h>
+#include <include/render/VeBVH.h>
+#include <include/render/VeRender.h>
+
+namespace Vedo {
+/**
+ * The native progressive render of Vedo. It implements the pipeline of "shaders/path_tracing.sksl"
+ * in C++ instead of evaluating the shader by Skia: the rays are traced in packets of SIMDWidth
+ * rays (8 with AVX2, 4 with SSE) through the same BVH, the image is split into tiles which are
+ * rendered by a thread pool. The accumulated image is in the same format of Render::MakeRaster, so the two paths can be
+ * compared directly. With the adaptive threshold of the camera the lanes of the stopped pixels are
+ * masked out of the packets, and the packets of stopped pixels only are skipped
+ */
+class NativeRender {
+public:
+	/**
+	 * Make a native render
+	 * @param RenderCamera The camera, its size and SPP decide the size of the image and the samples
+	 * to converge
+	 * @param Materials The material table of the scene, it is read by the first pass and again after
+	 * Update like the objects, so it should live as long as the render
+	 * @param Objects The objects of the scene, they are read by the first pass and again after Update,
+	 * so they should live as long as the render
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @param TileSize The width and height of a tile in pixels
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @return The render instance
+	 */
+	static std::unique_ptr<NativeRender> Make(const Camera &RenderCamera, const MaterialTable &Materials,
+											  std::vector<Object *> Objects, int SamplePerPass = 1,
+											  int TileSize = 64, int ThreadCount = 0);
+	/**
+	 * Make a native render with the BVH built before, like the BVH of a scene file, the first pass
+	 * takes it as it is instead of building it
+	 * @param RenderCamera The camera, its size and SPP decide the size of the image and the samples
+	 * to converge
+	 * @param Materials The material table of the scene, it should live as long as the render
+	 * @param Objects The objects of the scene, they should live as long as the render
+	 * @param Tree The BVH built with the objects in the same order
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @param TileSize The width and height of a tile in pixels
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @return The render instance
+	 */
+	static std::unique_ptr<NativeRender> Make(const Camera &RenderCamera, const MaterialTable &Materials,
+											  std::vector<Object *> Objects, std::unique_ptr<BVH> Tree,
+											  int SamplePerPass = 1, int TileSize = 64, int ThreadCount = 0);
+	/**
+	 * Make a native render of the scene with the instances, which is traced through the two level BVH
+	 * @param RenderCamera The camera, its size and SPP decide the size of the image and the samples
+	 * to converge
+	 * @param Materials The material table of the scene, it should live as long as the render
+	 * @param Objects The objects of the scene and the prototypes of the instances, they should live as
+	 * long as the render
+	 * @param Instances The instances of the prototypes, they are read by the first pass and again
+	 * after Update like the objects, so they should live as long as the render
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @param TileSize The width and height of a tile in pixels
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @return The render instance
+	 */
+	static std::unique_ptr<NativeRender> Make(const Camera &RenderCamera, const MaterialTable &Materials,
+											  std::vector<Object *> Objects, std::vector<Instance *> Instances,
+											  int SamplePerPass = 1, int TileSize = 64, int ThreadCount = 0);
+
+public:
+	/**
+	 * Drop the accumulated image, it should be called when the scene or the camera is changed
+	 */
+	void Reset();
+	/**
+	 * Take the changes of the objects, the instances or the materials, the next pass flattens the
+	 * scene again and refits the BVH, the moved instances build the top level BVH again. The scene
+	 * is built once otherwise, Reset should be called as well to drop the image of the old scene
+	 */
+	void Update();
+	/**
+	 * Render a pass and blend it into the accumulated image
+	 * @return Whether a pass is rendered, false when the image has converged
+	 */
+	bool Progress();
+	/**
+	 * Render the passes until the image converges
+	 */
+	void Converge();
+	/**
+	 * Draw the accumulated image onto the canvas
+	 * @param Canvas The target canvas
+	 */
+	void Present(SkCanvas *Canvas);
+	/**
+	 * Get the snapshot of the accumulated image
+	 * @return The snapshot image
+	 */
+	sk_sp<SkImage> Snapshot();
+	/**
+	 * Save the accumulated image as a PNG file, the float color is clamped into 8-bit sRGB
+	 * @param Path The path of the PNG file
+	 */
+	void Save(const std::string &Path);
+
+public:
+	/**
+	 * Get the count of the rendered passes
+	 * @return The count of the rendered passes
+	 */
+	[[nodiscard]] int Pass() const {
+		return _pass;
+	}
+	/**
+	 * Get the accumulated samples per pixel, the pixels stopped by the adaptive sampling take fewer
+	 * @return The accumulated samples per pixel
+	 */
+	[[nodiscard]] int Sample() const {
+		return _pass * _samplePerPass;
+	}
+	/**
+	 * Whether the accumulated samples reach the SPP of the camera, or all the pixels are stopped by the
+	 * adaptive sampling
+	 * @return Whether the image has converged
+	 */
+	[[nodiscard]] bool Converged() const {
+		return _adaptive != nullptr ? _adaptive->Converged() : Sample() >= static_cast<int>(_camera->SPP);
+	}
+	/**
+	 * Get the adaptive sampling of the render
+	 * @return The adaptive sampling instance, nullptr when the adaptive sampling is off
+	 */
+	[[nodiscard]] const AdaptiveSampling *Adaptive() const {
+		return _adaptive.get();
+	}
+
+private:
+	/**
+	 * The objects and the materials of the scene in structure of arrays, it is flattened from the
+	 * objects and the material table by the first pass and the pass after Update
+	 */
+	struct Scene {
+		std::vector<int>   Shape;
+		std::vector<float> CenterX;
+		std::vector<float> CenterY;
+		std::vector<float> CenterZ;
+		std::vector<float> Radius;
+
+		/**
+		 * The materials indexed by the material of the objects
+		 */
+		std::vector<int>   Kind;
+		std::vector<float> AlbedoX;
+		std::vector<float> AlbedoY;
+		std::vector<float> AlbedoZ;
+		std::vector<float> Fuzz;
+		std::vector<float> IndexRefraction;
+
+		/**
+		 * The mesh of each object and the number of its first triangle through all the meshes, the
+		 * BVH leaves refer to the triangles by that number
+		 */
+		std::vector<const Mesh *> Meshes;
+		std::vector<int>		  TriangleBase;
+	};
+
+private:
+	NativeRender(const Camera &RenderCamera, const MaterialTable &Materials, std::vector<Object *> Objects,
+				 sk_sp<SkSurface> Accumulation, int SamplePerPass, int TileSize, int ThreadCount);
+
+private:
+	/**
+	 * Flatten the objects and the materials into the scene and build the BVH over the objects, the
+	 * BVH is refitted instead when the scene has been built before
+	 */
+	void BuildScene();
+	/**
+	 * Render a tile and blend it into the accumulated image
+	 * @param Region The region of the tile
+	 * @param Pixels The pixels of the accumulation surface
+	 * @param Seed The random seed of the pass
+	 */
+	void RenderTile(const SkIRect &Region, const SkPixmap &Pixels, uint32_t Seed);
+	/**
+	 * Trace a packet of rays through the scene
+	 * @param Origin The origins of the rays
+	 * @param Direction The directions of the rays
+	 * @param Active The lanes holding a valid ray
+	 * @param Random The random streams of the lanes, they go on through the bounces
+	 * @param Sample The index of the sample in the pass, which decides the points of the bounces
+	 * @return The color of the rays
+	 */
+	SIMDVec3 Trace(SIMDVec3 Origin, SIMDVec3 Direction, SIMDMask Active, SIMDRandom &Random, int Sample) const;
+
+private:
+	const Camera		*_camera;
+	const MaterialTable	*_materials;
+	std::vector<Object *>	_objects;
+	std::vector<Instance *> _instances;
+	Scene					_scene;
+	std::unique_ptr<BVH>	_bvh;
+	bool					_sceneBuilt	  = false;
+	bool					_sceneChanged = true;
+
+private:
+	sk_sp<SkSurface>			_accumulation;
+	std::unique_ptr<SkExecutor> _executor;
+
+private:
+	int			 _samplePerPass;
+	int			 _tileSize;
+	int			 _pass;
+	std::mt19937 _random;
+	Sampler		 _sampler;
+
+private:
+	std::unique_ptr<AdaptiveSampling> _adaptive;
+};
+} // namespace Vedo
\ No newline at end of file
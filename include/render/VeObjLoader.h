@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeObjLoader.h
+ * \brief The loader of the Wavefront OBJ meshes
+ */
+
+#pragma once
+
+#include <include/render/VeMesh.h>
+
+#include <string_view>
+
+namespace Vedo {
+VeRegisterException(ObjOpenFailure, R"(Vedo OBJ : Could not open the OBJ file "{}")");
+VeRegisterException(ObjParseFailure, R"(Vedo OBJ : Invalid statement "{}")");
+
+/**
+ * The loader of the Wavefront OBJ meshes. Only the positions of the vertices and the faces are read,
+ * the polygons are split into triangle fans, the other statements are skipped. The text is split into
+ * chunks at the line boundaries which are parsed in parallel by two passes: the first pass counts the
+ * vertices and the triangles of each chunk, so every chunk knows where its vertices and triangles
+ * start, then the second pass parses the numbers by std::from_chars and writes them directly into the
+ * buffers of the mesh
+ */
+class ObjLoader {
+public:
+	/**
+	 * Load the mesh from the OBJ file. It will throw an ObjOpenFailure exception when the file could
+	 * not be read, or an ObjParseFailure exception when a vertex or a face is invalid
+	 * @param Path The path of the file
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @return The mesh instance
+	 */
+	static std::unique_ptr<Mesh> Load(const std::string &Path, int ThreadCount = 0);
+	/**
+	 * Parse the mesh from the text of an OBJ file. It will throw an ObjParseFailure exception when a
+	 * vertex or a face is invalid
+	 * @param Text The text of the OBJ file
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @return The mesh instance
+	 */
+	static std::unique_ptr<Mesh> Parse(std::string_view Text, int ThreadCount = 0);
+
+private:
+	/**
+	 * The chunk of the text parsed by a task
+	 */
+	struct Chunk {
+		const char *Begin;
+		const char *End;
+
+		size_t VertexCount	 = 0;
+		size_t TriangleCount = 0;
+		/**
+		 * The first vertex and the first triangle written by the chunk
+		 */
+		size_t FirstVertex	 = 0;
+		size_t FirstTriangle = 0;
+
+		std::exception_ptr Error;
+	};
+
+private:
+	/**
+	 * Count the vertices and the triangles of the chunk
+	 * @param Target The chunk
+	 */
+	static void Count(Chunk &Target);
+	/**
+	 * Parse the vertices and the triangles of the chunk into the mesh
+	 * @param Target The chunk
+	 * @param Output The mesh, its buffers have been resized to hold all the chunks
+	 */
+	static void Fill(const Chunk &Target, Mesh &Output);
+};
+} // namespace Vedo
\ No newline at end of file
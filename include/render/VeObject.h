@@ -27,46 +27,62 @@
 
 #pragma once
 
-#include <include/math/VeVector.h>
-#include <include/shader/VeShader.h>
+#include <include/render/VeMaterial.h>
 
 namespace Vedo {
-constexpr int LambertMaterial	 = 0;
-constexpr int MetalMaterial		 = 1;
-constexpr int DielectricMaterial = 2;
-
 constexpr int SphereGeometry = 0;
+constexpr int MeshGeometry	 = 1;
+
+class Mesh;
 
 /**
  * The object of the world object
  */
-class Object : public IShaderStructureUniform {
+class Object : public ShaderStructure<Object> {
 public:
-	std::vector<std::string> PropertyList() override {
-		return {"Material", "Shape", "Center", "Radius", "Albedo", "Fuzz", "IndexRefraction"};
-	}
-	std::map<std::string, std::string> PropertyValue() override {
-		return {
-			{ "Material", std::to_string(Material) },
-			{ "Shape", std::to_string(Shape) },
-			{ "Center", MathUniform::UniformVec3(Center) },
-			{ "Radius", std::to_string(Radius) },
-			{ "Albedo", MathUniform::UniformVec3(Albedo) },
-			{ "Fuzz", std::to_string(Fuzz) },
-			{ "IndexRefraction", std::to_string(IndexRefraction) }
-		};
+	static constexpr auto ShaderFields() {
+		return MakeShaderFields(ShaderFieldOf<&Object::Material>("Material"), ShaderFieldOf<&Object::Shape>("Shape"),
+								ShaderFieldOf<&Object::Center>("Center"), ShaderFieldOf<&Object::Radius>("Radius"));
 	}
 	[[nodiscard]] std::string Type() const override {
 		return "Object";
 	}
 
 public:
+	/**
+	 * The index of the material in the material table of the scene
+	 */
 	int Material;
 	int Shape;
 	Vec3 Center;
-	Vec3 Albedo;
 	float Radius;
-	float Fuzz;
-	float IndexRefraction;
+
+	/**
+	 * The triangle mesh of the object in MeshGeometry shape, the center and the radius are not used
+	 * by the mesh. It is not passed to the shader, the shader reads the meshes from Vedo::MeshBuffer
+	 */
+	const Mesh *Geometry = nullptr;
+};
+
+/**
+ * The instance of an object placed by a transform. The instanced object is a prototype, it is only
+ * drawn by its instances, which share its geometry and the bottom level BVH built over its geometry,
+ * so the scene only grows with the unique geometries. An instance takes the material of its
+ * prototype unless it overrides it
+ */
+struct Instance {
+	/**
+	 * The index of the prototype in the objects of the scene
+	 */
+	int Object;
+	/**
+	 * The affine transform from the space of the prototype to the world
+	 */
+	Matrix Transform;
+	/**
+	 * The index of the material of the instance in Vedo::MaterialTable, -1 to take the material of
+	 * the prototype
+	 */
+	int Material = -1;
 };
 } // namespace Vedo
\ No newline at end of file
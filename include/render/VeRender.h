@@ -27,3 +27,189 @@
 
 #pragma once
 
+#include <include/render/VeAdaptive.h>
+#include <include/render/VeCamera.h>
+
+#include <latch>
+#include <random>
+
+namespace Vedo {
+VeRegisterException(RenderCreateFailure, R"(Vedo Render : Could not create the {})");
+VeRegisterException(RenderSaveFailure, R"(Vedo Render : Could not save the image to "{}")");
+
+/**
+ * The progressive render of Vedo. Instead of running all the samples of a pixel in one frame, every
+ * pass only renders a few samples per pixel into a float accumulation surface, the passes are
+ * blended by running average, so a preview image is available after the first pass and converges
+ * over time. The shader is expected to declare "uniform float u_seed", the link variable "$u_SPP$"
+ * for the samples per pass and the array "u_sample" for the points of the sampler of the camera.
+ * With the adaptive threshold of the camera the raster renders draw each pass into a surface of its
+ * own and blend it into the pixels still sampled, the shader skips the other pixels by the mask
+ * "uniform shader u_converged"
+ */
+class Render {
+public:
+	/**
+	 * Make a progressive render on the GPU context
+	 * The adaptive threshold of the camera is ignored, the pixels on the GPU are not read back by the
+	 * passes. The passes are accumulated in F32 when the context supports it, otherwise in F16, where
+	 * the passes after the first few hundred hardly change the image any more
+	 * @param Context The GPU context which the accumulation surface is created on
+	 * @param RenderShader The shader with the scene bound
+	 * @param RenderCamera The camera, its size and SPP decide the size of the image and the samples
+	 * to converge
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @return The render instance
+	 */
+	static std::unique_ptr<Render> MakeProgressive(GrRecordingContext *Context, std::unique_ptr<Shader> RenderShader,
+												   const Camera &RenderCamera, int SamplePerPass = 1);
+	/**
+	 * Make a progressive render on the CPU, the runtime effect is evaluated by the raster backend
+	 * of Skia, so it does not need any GPU or window system. It is the entry of the batch jobs
+	 * on the machines without GPU
+	 * @param RenderShader The shader with the scene bound
+	 * @param RenderCamera The camera, its size and SPP decide the size of the image and the samples
+	 * to converge
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @param ColorType The color type of the accumulation surface, only kRGBA_F16_SkColorType and
+	 * kRGBA_F32_SkColorType are accepted, the adaptive sampling only accepts kRGBA_F32_SkColorType
+	 * @return The render instance
+	 */
+	static std::unique_ptr<Render> MakeRaster(std::unique_ptr<Shader> RenderShader, const Camera &RenderCamera,
+											  int		  SamplePerPass = 1,
+											  SkColorType ColorType		= kRGBA_F32_SkColorType);
+	/**
+	 * Make a progressive render on the CPU which renders the passes in tiles. Every pass splits the
+	 * image into tiles, each tile is drawn on its own raster surface over the tile region of the
+	 * accumulation pixels by a thread pool, so the tiles are stitched in place and the throughput
+	 * scales with the count of the cores
+	 * @param RenderShader The shader with the scene bound
+	 * @param RenderCamera The camera, its size and SPP decide the size of the image and the samples
+	 * to converge
+	 * @param SamplePerPass The samples per pixel rendered by each pass
+	 * @param TileSize The width and height of a tile in pixels
+	 * @param ThreadCount The count of the worker threads, 0 for the count of the cores
+	 * @param ColorType The color type of the accumulation surface, only kRGBA_F16_SkColorType and
+	 * kRGBA_F32_SkColorType are accepted, the adaptive sampling only accepts kRGBA_F32_SkColorType
+	 * @return The render instance
+	 */
+	static std::unique_ptr<Render> MakeTiledRaster(std::unique_ptr<Shader> RenderShader, const Camera &RenderCamera,
+												   int SamplePerPass = 1, int TileSize = 64, int ThreadCount = 0,
+												   SkColorType ColorType = kRGBA_F32_SkColorType);
+
+public:
+	/**
+	 * Drop the accumulated image, it should be called when the scene or the camera is changed
+	 */
+	void Reset();
+	/**
+	 * Render a pass and blend it into the accumulation surface
+	 * @return Whether a pass is rendered, false when the image has converged
+	 */
+	bool Progress();
+	/**
+	 * Draw the accumulated image onto the canvas
+	 * @param Canvas The target canvas
+	 */
+	void Present(SkCanvas *Canvas);
+	/**
+	 * Get the snapshot of the accumulated image
+	 * @return The snapshot image
+	 */
+	sk_sp<SkImage> Snapshot();
+	/**
+	 * Render the passes until the image converges
+	 */
+	void Converge();
+	/**
+	 * Save the accumulated image as a PNG file, the float color is clamped into 8-bit sRGB
+	 * @param Path The path of the PNG file
+	 */
+	void Save(const std::string &Path);
+	/**
+	 * Save the image of a surface as a PNG file, the float color is clamped into 8-bit sRGB
+	 * @param Surface The surface to be saved
+	 * @param Path The path of the PNG file
+	 */
+	static void SaveSurface(SkSurface *Surface, const std::string &Path);
+
+public:
+	/**
+	 * Get the shader of the render, the scene bound to the shader can be changed through it
+	 * @return The shader instance
+	 */
+	[[nodiscard]] Shader *RenderShader() const {
+		return _shader.get();
+	}
+	/**
+	 * Get the count of the rendered passes
+	 * @return The count of the rendered passes
+	 */
+	[[nodiscard]] int Pass() const {
+		return _pass;
+	}
+	/**
+	 * Get the accumulated samples per pixel, the pixels stopped by the adaptive sampling take fewer
+	 * @return The accumulated samples per pixel
+	 */
+	[[nodiscard]] int Sample() const {
+		return _pass * _samplePerPass;
+	}
+	/**
+	 * Whether the accumulated samples reach the SPP of the camera, or all the pixels are stopped by the
+	 * adaptive sampling
+	 * @return Whether the image has converged
+	 */
+	[[nodiscard]] bool Converged() const {
+		return _adaptive != nullptr ? _adaptive->Converged() : Sample() >= _sampleTarget;
+	}
+	/**
+	 * Get the adaptive sampling of the render
+	 * @return The adaptive sampling instance, nullptr when the adaptive sampling is off
+	 */
+	[[nodiscard]] const AdaptiveSampling *Adaptive() const {
+		return _adaptive.get();
+	}
+
+private:
+	Render(std::unique_ptr<Shader> RenderShader, sk_sp<SkSurface> Accumulation, const Camera &RenderCamera,
+		   int SamplePerPass);
+
+private:
+	/**
+	 * Draw the pass paint onto every tile of the surface by the thread pool, and wait for all the
+	 * tiles done
+	 * @param Paint The paint of the pass
+	 * @param Target The raster surface to draw
+	 */
+	void DrawTiles(const SkPaint &Paint, SkSurface *Target);
+	/**
+	 * Render a pass into the pass surface and blend it into the pixels still sampled by the adaptive
+	 * sampling
+	 */
+	void AdaptivePass();
+
+private:
+	std::unique_ptr<Shader> _shader;
+	sk_sp<SkSurface>		_accumulation;
+
+private:
+	std::unique_ptr<SkExecutor> _executor;
+	int							_tileSize;
+
+private:
+	int			 _samplePerPass;
+	int			 _sampleTarget;
+	int			 _pass;
+	std::mt19937 _random;
+
+private:
+	Sampler _sampler;
+	int		_samplerKind;
+	int		_depth;
+
+private:
+	std::unique_ptr<AdaptiveSampling> _adaptive;
+	sk_sp<SkSurface>				  _passSurface;
+};
+} // namespace Vedo
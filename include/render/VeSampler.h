@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeSampler.h
+ * \brief The low discrepancy sampler of the Vedo renderer
+ */
+
+#pragma once
+
+#include <include/math/VeVector.h>
+#include <include/shader/VeShaderStructure.h>
+
+#include <cstdint>
+
+namespace Vedo {
+constexpr int RandomSampler = 0;
+constexpr int SobolSampler	= 1;
+
+/**
+ * The point of four sample dimensions, the pixel offset and the defocus disk of the camera, or the
+ * direction, the chance and the Russian roulette of a bounce
+ */
+class SamplePoint : public ShaderStructure<SamplePoint> {
+public:
+	static constexpr auto ShaderFields() {
+		return MakeShaderFields(ShaderFieldOf<&SamplePoint::Value>("Value"));
+	}
+	[[nodiscard]] std::string Type() const override {
+		return "SamplePoint";
+	}
+
+public:
+	Vec4 Value = {0.f, 0.f, 0.f, 0.f};
+};
+
+/**
+ * The sample points shared by all the pixels of a pass. The Sobol sampler takes the padded
+ * Owen-scrambled Sobol sequence: every pair of dimensions is the 2D Sobol sequence shuffled and
+ * scrambled by a seed of its own, so the dimensions are not correlated and the samples of a pixel
+ * stay stratified through the passes. The pixels rotate the points by their own random offsets, the
+ * Cranley-Patterson rotation, which keeps the stratification and does not need any bit operation in
+ * the shader. The points of the random sampler are zero, so the rotated points are just the random
+ * numbers of the sample
+ */
+class Sampler {
+public:
+	/**
+	 * Make a sampler
+	 * @param Seed The seed of the scrambling, it is kept by all the passes
+	 */
+	explicit Sampler(uint32_t Seed);
+
+public:
+	/**
+	 * Build the points of the samples of a pass, every sample takes Depth + 1 points: the camera
+	 * point and then a point for each bounce
+	 * @param Kind The kind of the sampler, RandomSampler or SobolSampler
+	 * @param First The index of the first sample of the pass through all the passes
+	 * @param Count The count of the samples in the pass
+	 * @param Depth The max depth of the paths
+	 */
+	void Generate(int Kind, int First, int Count, int Depth);
+	/**
+	 * Get the Owen-scrambled 2D Sobol point of an index, the index is shuffled by the seed before
+	 * @param Index The index of the point in the sequence
+	 * @param Seed The seed of the shuffling and the scrambling
+	 * @return The point in [0, 1)^2
+	 */
+	static Vec2 Sobol(uint32_t Index, uint32_t Seed);
+
+public:
+	/**
+	 * Get the point of a sample in the pass
+	 * @param Sample The index of the sample in the pass
+	 * @param Dimension 0 for the camera point, 1 + N for the point of the bounce N
+	 */
+	[[nodiscard]] const Vec4 &Point(int Sample, int Dimension) const {
+		return _points[Sample * _stride + Dimension].Value;
+	}
+	/**
+	 * Get the uniforms of the points for the u_sample array of the shader, the pointers stay valid
+	 * until the points are generated again
+	 * @return The pointers to the points in the order of the samples
+	 */
+	std::vector<SamplePoint *> Uniforms();
+
+private:
+	uint32_t				 _seed;
+	int						 _stride;
+	std::vector<SamplePoint> _points;
+};
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeSceneFile.h
+ * \brief The binary scene file of Vedo, which is mapped into the memory when it is opened
+ */
+
+#pragma once
+
+#include <include/render/VeBVH.h>
+#include <include/render/VeCamera.h>
+#include <include/render/VeMesh.h>
+
+namespace Vedo {
+VeRegisterException(SceneFileOpenFailure, R"(Vedo Scene : Could not open the scene file "{}")");
+VeRegisterException(SceneFileInvalidFormat, R"(Vedo Scene : "{}" is not a scene file of this version)");
+VeRegisterException(SceneFileSaveFailure, R"(Vedo Scene : Could not save the scene to "{}")");
+
+/**
+ * The binary scene file holding the camera, the objects, the meshes and the BVH of a scene. The file
+ * starts with a header of the version and the table of the sections, every section is an array of
+ * plain records aligned to 64 bytes, and the vertices of the meshes are stored as structure-of-arrays
+ * like Vedo::Mesh. Opening the file maps it into the memory instead of reading it, the meshes view
+ * the mapped vertices and indices without copying them, and the BVH is taken from the stored nodes
+ * without building it again, so a huge scene opens in the time of mapping the file and checking its
+ * indices
+ */
+class SceneFile {
+public:
+	/**
+	 * The version of the format, the files of other versions are refused
+	 */
+	static constexpr uint32_t Version = 3;
+
+public:
+	/**
+	 * Save the scene into the file, the meshes shared by the objects are stored once. It will throw
+	 * a SceneFileSaveFailure exception when the file could not be written, the instanced BVH, the
+	 * object referring to a missing material and the mesh object without a mesh are not stored either
+	 * @param Path The path of the file
+	 * @param SceneCamera The camera of the scene
+	 * @param Materials The material table referred by the objects
+	 * @param Objects The objects of the scene
+	 * @param Tree The BVH built with the objects in the same order
+	 */
+	static void Save(const std::string &Path, const Camera &SceneCamera, const MaterialTable &Materials,
+					 const std::vector<Object *> &Objects, const BVH &Tree);
+	/**
+	 * Open the scene file by mapping it into the memory. It will throw a SceneFileOpenFailure
+	 * exception when the file could not be mapped, or a SceneFileInvalidFormat exception when the
+	 * file is not a scene file of this version. The file is not trusted: the tables, the shapes and
+	 * the vertex indices are checked, so a corrupt file is refused instead of being read out of range
+	 * @param Path The path of the file
+	 * @return The scene file instance, the meshes and the objects are valid as long as it
+	 */
+	static std::unique_ptr<SceneFile> Open(const std::string &Path);
+
+public:
+	SceneFile(const SceneFile &)			= delete;
+	SceneFile &operator=(const SceneFile &) = delete;
+	~SceneFile();
+
+public:
+	/**
+	 * Get the camera of the scene, it has been initialized
+	 */
+	[[nodiscard]] Camera &SceneCamera() {
+		return _camera;
+	}
+	/**
+	 * Get the material table of the scene, the objects refer to it by index
+	 */
+	[[nodiscard]] MaterialTable &Materials() {
+		return _materials;
+	}
+	/**
+	 * Get the objects of the scene, the mesh objects refer to the meshes of the file
+	 * @return The pointers to the objects
+	 */
+	[[nodiscard]] std::vector<Object *> Objects();
+	/**
+	 * Get the meshes of the scene, they view the mapped memory of the file
+	 */
+	[[nodiscard]] const std::vector<std::unique_ptr<Mesh>> &Meshes() const {
+		return _meshes;
+	}
+	/**
+	 * Make the BVH of the objects from the stored nodes, the nodes are copied as they are. It will
+	 * throw a SceneFileInvalidFormat exception when a node refers to a missing object
+	 * @return The BVH instance
+	 */
+	[[nodiscard]] std::unique_ptr<BVH> MakeBVH() const;
+	/**
+	 * Get the size of the mapped file
+	 * @return The size in bytes
+	 */
+	[[nodiscard]] size_t Size() const {
+		return _size;
+	}
+
+private:
+	SceneFile() = default;
+
+private:
+	/**
+	 * Get the records of a section of the mapped file
+	 * @tparam RecordType The type of the records
+	 * @param Section The index of the section
+	 * @return The records
+	 */
+	template <class RecordType> [[nodiscard]] std::span<const RecordType> Records(int Section) const;
+
+private:
+	const uint8_t *_data = nullptr;
+	size_t		   _size = 0;
+	std::string	   _path;
+
+private:
+	Camera							   _camera;
+	MaterialTable					   _materials;
+	std::vector<Object>				   _objects;
+	std::vector<std::unique_ptr<Mesh>> _meshes;
+};
+} // namespace Vedo
\ No newline at end of file
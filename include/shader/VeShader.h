@@ -30,10 +30,10 @@
 #include <include/VeBase.h>
 #include <include/skia/VeSkia.h>
 
-#include <thirdparty/stb_c_lexer/stb_c_lexer.h>
-
+#include <algorithm>
 #include <fstream>
 #include <map>
+#include <span>
 
 namespace Vedo {
 
@@ -42,6 +42,70 @@ VeRegisterException(ShaderCreateFailure, "Could not create the shader with error
 VeRegisterException(ShaderInvalidUniform, R"(Vedo Shader : Unknown uniform structure "{}")");
 VeRegisterException(ShaderInvalidVariable, R"(Vedo Shader : Unknown variable "{}")");
 VeRegisterException(ShaderInvalidImportFile, R"(Vedo Shader : Unknown file importing "{}")");
+VeRegisterException(ShaderInvalidDirective, R"(Vedo Shader : Invalid directive "@{}")");
+VeRegisterException(ShaderUnpackableUniform, R"(Vedo Shader : Uniform structure "{}" can not be packed)");
+VeRegisterException(ShaderEmptyUniform, R"(Vedo Shader : The empty packed array "{}" has no layout)");
+
+/**
+ * The type of a property in the uniform structure, it decides how the property is laid out in the
+ * packed uniform array
+ */
+enum class ShaderPropertyType { Int, Float, Vec2, Vec3, Vec4 };
+
+/**
+ * Get the count of float slots that the property type takes in the packed uniform array
+ * @param Type The property type
+ * @return The count of float slots
+ */
+constexpr int ShaderPropertySize(ShaderPropertyType Type) {
+	switch (Type) {
+	case ShaderPropertyType::Vec2:
+		return 2;
+	case ShaderPropertyType::Vec3:
+		return 3;
+	case ShaderPropertyType::Vec4:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
+class IShaderStructureUniform;
+
+/**
+ * The descriptor of a field in the uniform structure, the descriptors are usually generated at
+ * compile time by Vedo::ShaderStructure
+ */
+struct ShaderField {
+	std::string_view   Name;
+	ShaderPropertyType Type;
+	/**
+	 * The offset of the field in the packed block, in float slots
+	 */
+	int Offset;
+	/**
+	 * Read the value of the field from the structure into float slots
+	 */
+	void (*Read)(const IShaderStructureUniform *Structure, float *Data);
+};
+
+/**
+ * The way how a uniform array is passed to the shader
+ */
+enum class ShaderUniformMode {
+	/**
+	 * The values are baked into the translated code as literal, any change of the values requires
+	 * the shader to be compiled again
+	 */
+	Inline,
+	/**
+	 * The values are laid out into a packed float uniform array, only the capacity of the array is
+	 * baked into the translated code, so the values can be changed without compiling. The capacity
+	 * is the power of two not less than the length, and the live length is passed by uniform, so
+	 * an array growing inside the same capacity will not cause compiling either
+	 */
+	Packed
+};
 
 /**
  * The interface for uniform passable structure, when a structure needs to be passed by Vedo
@@ -64,6 +128,30 @@ public:
 	 * @return The type name of the uniform structure
 	 */
 	[[nodiscard]] virtual std::string Type() const = 0;
+	/**
+	 * Get the type list of the structure in the same order of the property list, it is required
+	 * when the structure is passed in ShaderUniformMode::Packed mode
+	 * @return The type list in std::vector<ShaderPropertyType> type
+	 */
+	virtual std::vector<ShaderPropertyType> PropertyType() {
+		throw ShaderUnpackableUniform(Type().c_str());
+	}
+	/**
+	 * Write the property values into the packed float block in the same order of the property
+	 * list, it is required when the structure is passed in ShaderUniformMode::Packed mode
+	 * @param Data The begin of the block for this structure
+	 */
+	virtual void PropertyData(float *Data) {
+		throw ShaderUnpackableUniform(Type().c_str());
+	}
+	/**
+	 * Get the field descriptors of the structure, when they are provided, the shader maker will
+	 * write the values directly instead of calling PropertyValue
+	 * @return The field descriptors, empty when the structure only provides the string form
+	 */
+	[[nodiscard]] virtual std::span<const ShaderField> Fields() const {
+		return {};
+	}
 };
 
 /**
@@ -121,19 +209,67 @@ public:
 	 * @param Data The data instance
 	 */
 	template <class DataType> void BindUniform(const char *Tag, const DataType &Data) {
-		_linkReplacement[std::format("${}$", Tag)] = std::to_string(Data);
+		auto  value = std::to_string(Data);
+		auto &link	= _linkReplacement[std::format("${}$", Tag)];
+		if (link != value) {
+			link   = std::move(value);
+			_dirty = true;
+		}
+	}
+
+	/**
+	 * Set the value of a real uniform variable declared by "uniform" in the shader code, the value
+	 * is written into the uniform data every time the Skia shader is made, so changing it will not
+	 * cause the shader to be compiled again
+	 * @tparam DataType The data type must have the same layout as the uniform, like float, int or
+	 * Vedo::Vec3 for float3
+	 * @param Name The name of the uniform variable
+	 * @param Data The data instance
+	 */
+	template <class DataType>
+		requires std::is_trivially_copyable_v<DataType>
+	void SetUniform(const std::string &Name, const DataType &Data) {
+		auto &value = _uniformValue[Name];
+		value.resize(sizeof(DataType));
+		memcpy(value.data(), &Data, sizeof(DataType));
+	}
+
+	/**
+	 * Bind a child shader to the shader, which is declared by "uniform shader" in the shader code
+	 * and sampled by "eval", the children unbound are replaced by the empty shader. Changing the
+	 * child will not cause the shader to be compiled again
+	 * @param Name The name of the child shader
+	 * @param Child The Skia shader instance
+	 */
+	void BindChild(const std::string &Name, sk_sp<SkShader> Child) {
+		_children[Name] = std::move(Child);
 	}
 
 	/**
-	 * Bind an array uniform to the shader
+	 * Bind an array uniform to the shader, in ShaderUniformMode::Packed mode, the values of the
+	 * structures are read every time the Skia shader is made, so changing the values of a bound
+	 * array will not cause the shader to be compiled again. An empty packed array still reserves one
+	 * element laid out by a default-constructed structure, since SKSL can not declare an empty array.
+	 * It will throw a ShaderEmptyUniform exception when the structure type has no default constructor
 	 * @tparam UniformType The uniform structure type
 	 * @param Name The name of the structure
 	 * @param arrayList The array list instance
+	 * @param Mode The way how the array is passed to the shader
 	 */
 	template<class UniformType>
 		requires std::is_base_of_v<IShaderStructureUniform, UniformType>
-	void BindUniformArray(const std::string &Name, std::vector<UniformType*> arrayList) {
-		_uniformReplacement[Name] = arrayList;
+	void BindUniformArray(const std::string &Name, std::vector<UniformType*> arrayList,
+						  ShaderUniformMode Mode = ShaderUniformMode::Inline) {
+		if constexpr (std::is_default_constructible_v<UniformType>) {
+			if (arrayList.empty() && Mode == ShaderUniformMode::Packed) {
+				UniformType layout;
+				BindStructures(Name, {}, Mode, &layout);
+
+				return;
+			}
+		}
+
+		BindStructures(Name, std::vector<IShaderStructureUniform *>(arrayList.begin(), arrayList.end()), Mode);
 	}
 
 public:
@@ -143,22 +279,186 @@ public:
 	 * @return The translated code
 	 */
 	std::string MakeCode();
+	/**
+	 * Make the runtime effect by Vedo shader object, the effect is the one built while validating
+	 * the translated code, when the compiler reports an error about shader it will throw a
+	 * ShaderCreateFailure exception
+	 * @return The runtime effect of the translated code
+	 */
+	sk_sp<SkRuntimeEffect> MakeEffect();
+	/**
+	 * Make the Skia shader by Vedo shader object, when the compiler reports an error about shader
+	 * it will throw a ShaderCreateFailure exception
+	 * @return The Skia shader instance
+	 */
+	sk_sp<SkShader> MakeShader();
+	/**
+	 * Get the translated code of the last making, it is used for debugging
+	 * @return The translated code
+	 */
+	[[nodiscard]] const std::string &LinkedCode() const {
+		return _linkedCode;
+	}
+	/**
+	 * Translate the shader code without compiling it. The code is parsed only once into literal
+	 * segments and substitution slots, translating is a concatenation of the segments and the bound
+	 * values. The output is cleared first and its memory is reused
+	 * @param Output The output of the translated code
+	 */
+	void Preprocess(std::string &Output);
+
+private:
+	/**
+	 * The uniform array bound to the shader
+	 */
+	struct UniformArray {
+		std::vector<IShaderStructureUniform *> Structures;
+		ShaderUniformMode						Mode;
+
+		/**
+		 * The property layout of the structure, only available in ShaderUniformMode::Packed mode
+		 */
+		std::vector<std::string>		Names;
+		std::vector<ShaderPropertyType> Types;
+		int								Stride;
+		size_t							Capacity;
+
+		/**
+		 * The translated code of the packed array, it is kept until the layout changes
+		 */
+		std::string Code;
+	};
+
+	/**
+	 * The kind of the parsed segment
+	 */
+	enum class SegmentKind {
+		/**
+		 * The code copied to the output verbatim
+		 */
+		Literal,
+		/**
+		 * The link variable, whose text is the tag like "$tag$"
+		 */
+		Variable,
+		/**
+		 * The uniform array directive, whose text is the name of the array
+		 */
+		Uniform
+	};
+
+	/**
+	 * The segment of the parsed shader code
+	 */
+	struct Segment {
+		SegmentKind Kind;
+		std::string Text;
+		std::string StructureType;
+	};
+
+	/**
+	 * The compiled variant of the shader
+	 */
+	struct Variant {
+		std::string			   Code;
+		sk_sp<SkRuntimeEffect> Effect;
+		/**
+		 * The build count when the variant was used the last time, the least recently used
+		 * variant is evicted first
+		 */
+		size_t LastUse;
+	};
+
+	/**
+	 * The maximum count of the variants kept by a shader
+	 */
+	static constexpr size_t MaxVariant = 16;
 
 private:
 	/**
-	 * Preprocess the shader code and store in the linked code
-	 * @return The returned preprocessed string
+	 * Bind the structure list as a uniform array, it will throw a ShaderEmptyUniform exception when
+	 * a packed array is empty without a layout
+	 * @param Name The name of the structure
+	 * @param Structures The structure list
+	 * @param Mode The way how the array is passed to the shader
+	 * @param Layout The structure giving the layout of an empty packed array, it is not kept
+	 */
+	void BindStructures(const std::string &Name, std::vector<IShaderStructureUniform *> Structures,
+						ShaderUniformMode Mode, IShaderStructureUniform *Layout = nullptr);
+	/**
+	 * Translate the shader code and compile it when the translated code may be changed, the result
+	 * will be stored in the linked code and the effect
+	 */
+	void Build();
+	/**
+	 * Get the key of the current variant, the variants with the same key share the same
+	 * translated code, it is only meaningful when there is no inline array. The link variables
+	 * not used by the code are left out, binding them will not make a new variant
+	 * @return The key of the current variant
+	 */
+	[[nodiscard]] std::string VariantKey() const;
+	/**
+	 * Lay out the packed uniform arrays into the uniform data of the effect
+	 * @return The uniform data
 	 */
-	std::string Preprocess();
+	sk_sp<SkData> MakeUniformData();
+	/**
+	 * Parse the shader code into segments
+	 */
+	void Parse();
+	/**
+	 * Parse the uniform array directive at the cursor into a segment
+	 * @param Cursor The position after the "@" character
+	 * @param End The end of the code
+	 * @return The position after the directive
+	 */
+	const char *ParseUniform(const char *Cursor, const char *End);
+	/**
+	 * Translate the packed uniform array into SKSL code
+	 * @param Output The output of the translated code
+	 * @param Name The name of the uniform array
+	 * @param StructureType The type name of the structure in SKSL
+	 * @param Array The uniform array
+	 */
+	static void PackedUniformCode(std::string &Output, std::string_view Name, std::string_view StructureType,
+								  const UniformArray &Array);
+	/**
+	 * Translate the inline uniform array into SKSL code
+	 * @param Output The output of the translated code
+	 * @param Name The name of the uniform array
+	 * @param StructureType The type name of the structure in SKSL
+	 * @param Array The uniform array
+	 */
+	static void InlineUniformCode(std::string &Output, std::string_view Name, std::string_view StructureType,
+								  const UniformArray &Array);
+	/**
+	 * Append the SKSL literal of a field value to the buffer
+	 * @param Buffer The buffer to be appended
+	 * @param Type The type of the field
+	 * @param Data The float slots of the value
+	 */
+	static void AppendLiteral(std::string &Buffer, ShaderPropertyType Type, const float *Data);
 
 private:
 	explicit Shader(const char *ShaderCode);
 
 private:
-	std::string _code;
+	std::string			   _code;
+	std::vector<Segment>   _segments;
+	size_t				   _literalSize = 0;
+	bool				   _parsed		= false;
+	std::string			   _linkedCode;
+	sk_sp<SkRuntimeEffect> _effect;
+
+private:
+	std::map<std::string, std::string, std::less<>>  _linkReplacement;
+	std::map<std::string, UniformArray, std::less<>> _uniformReplacement;
+	std::map<std::string, std::vector<uint8_t>>		 _uniformValue;
+	std::map<std::string, sk_sp<SkShader>>			 _children;
+	std::map<std::string, Variant>					 _variants;
+	size_t											 _variantUse = 0;
 
 private:
-	std::map<std::string, std::string> _linkReplacement;
-	std::map<std::string, std::vector<IShaderStructureUniform*> > _uniformReplacement;
+	bool _dirty = true;
 };
 } // namespace Vedo
\ No newline at end of file
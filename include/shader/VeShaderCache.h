@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeShaderCache.h
+ * \brief The compiled shader cache of Vedo renderer
+ */
+
+#pragma once
+
+#include <include/shader/VeShader.h>
+
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+namespace Vedo {
+/**
+ * The process-wide cache of the compiled runtime effect, the effect is keyed by the hash of the
+ * preprocessed SKSL code, so that a linked shader will only be compiled once in the whole process.
+ * It keeps at most MaxEffect effects, the least recently used one is evicted first, since an inline
+ * array makes new code on every change of its values
+ */
+class ShaderCache {
+public:
+	/**
+	 * Get the process-wide shader cache instance
+	 * @return The shader cache instance
+	 */
+	static ShaderCache &Instance();
+
+public:
+	/**
+	 * Find the runtime effect of the preprocessed code, if the code has not been compiled yet, it
+	 * will be compiled and stored in the cache. When the compiler reports an error about shader it
+	 * will throw a ShaderCreateFailure exception
+	 * @param Code The preprocessed SKSL code
+	 * @return The runtime effect of the code
+	 */
+	sk_sp<SkRuntimeEffect> MakeEffect(const std::string &Code);
+	/**
+	 * Drop all the cached effects
+	 */
+	void Purge();
+	/**
+	 * Get the count of the cached effects
+	 * @return The count of the cached effects
+	 */
+	[[nodiscard]] size_t Size();
+
+public:
+	/**
+	 * Hash the code by 64-bit FNV-1a
+	 * @param Code The code to be hashed
+	 * @return The hash value of the code
+	 */
+	static uint64_t Hash(std::string_view Code);
+
+private:
+	struct Entry {
+		std::string			   Code;
+		sk_sp<SkRuntimeEffect> Effect;
+		/**
+		 * The request count when the effect was used the last time
+		 */
+		size_t LastUse;
+	};
+
+	/**
+	 * The maximum count of the effects kept by the cache
+	 */
+	static constexpr size_t MaxEffect = 64;
+
+	/**
+	 * Find the effect of the code in the cache and mark it as used, it should be called under the lock
+	 * @param Hash The hash of the code
+	 * @param Code The preprocessed SKSL code
+	 * @return The effect, null when the code is not cached
+	 */
+	sk_sp<SkRuntimeEffect> Find(uint64_t Hash, const std::string &Code);
+
+private:
+	std::mutex								 _mutex;
+	std::unordered_multimap<uint64_t, Entry> _effects;
+	size_t									 _use = 0;
+};
+
+/**
+ * The on-disk cache of the shader programs, it should be set as the persistent cache of the
+ * GPU context (GrContextOptions::fPersistentCache), then the program binaries generated from
+ * the runtime effects will be stored in the directory and reused by the next process. A cache
+ * file is named by the hash of the key and starts with the key, which is compared on loading
+ */
+class ShaderDiskCache : public GrContextOptions::PersistentCache {
+public:
+	/**
+	 * Create a disk cache in the specified directory, the directory will be created when
+	 * it does not exist
+	 * @param Directory The directory of the cache files
+	 */
+	explicit ShaderDiskCache(std::filesystem::path Directory);
+
+public:
+	sk_sp<SkData> load(const SkData &Key) override;
+	void		  store(const SkData &Key, const SkData &Data) override;
+
+private:
+	/**
+	 * Get the path of the cache file for the key
+	 * @param Key The key data from Skia
+	 * @return The path of the cache file
+	 */
+	[[nodiscard]] std::filesystem::path KeyPath(const SkData &Key) const;
+
+private:
+	std::filesystem::path _directory;
+	std::mutex			  _mutex;
+};
+} // namespace Vedo
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeShaderStructure.h
+ * \brief The compile-time field reflection for uniform structures of Vedo shader
+ */
+
+#pragma once
+
+#include <include/math/VeVector.h>
+#include <include/shader/VeShader.h>
+
+#include <array>
+
+namespace Vedo {
+/**
+ * Get the property type of a C++ field type
+ * @tparam Type The C++ type of the field
+ * @return The property type in the shader
+ */
+template <class Type> constexpr ShaderPropertyType ShaderTypeOf() {
+	if constexpr (std::is_same_v<Type, int>) {
+		return ShaderPropertyType::Int;
+	} else if constexpr (std::is_same_v<Type, float>) {
+		return ShaderPropertyType::Float;
+	} else if constexpr (std::is_same_v<Type, Vec2>) {
+		return ShaderPropertyType::Vec2;
+	} else if constexpr (std::is_same_v<Type, Vec3>) {
+		return ShaderPropertyType::Vec3;
+	} else {
+		static_assert(std::is_same_v<Type, Vec4>, "The field type can not be passed to the shader");
+		return ShaderPropertyType::Vec4;
+	}
+}
+
+/**
+ * The traits of a pointer to member field
+ */
+template <class Pointer> struct ShaderMemberTraits;
+template <class ClassType, class FieldType> struct ShaderMemberTraits<FieldType ClassType::*> {
+	using Class = ClassType;
+	using Type	= FieldType;
+};
+
+/**
+ * Read the field pointed by the member pointer into float slots
+ * @tparam Member The pointer to the member field
+ * @param Structure The structure to be read
+ * @param Data The float slots to be written
+ */
+template <auto Member> void ShaderFieldRead(const IShaderStructureUniform *Structure, float *Data) {
+	using Traits = ShaderMemberTraits<decltype(Member)>;
+
+	const auto &value = static_cast<const typename Traits::Class *>(Structure)->*Member;
+	if constexpr (std::is_same_v<typename Traits::Type, int> || std::is_same_v<typename Traits::Type, float>) {
+		Data[0] = static_cast<float>(value);
+	} else if constexpr (std::is_same_v<typename Traits::Type, Vec2>) {
+		Data[0] = value.x;
+		Data[1] = value.y;
+	} else if constexpr (std::is_same_v<typename Traits::Type, Vec3>) {
+		Data[0] = value.x;
+		Data[1] = value.y;
+		Data[2] = value.z;
+	} else {
+		Data[0] = value.x;
+		Data[1] = value.y;
+		Data[2] = value.z;
+		Data[3] = value.w;
+	}
+}
+
+/**
+ * Make the descriptor of a member field
+ * @tparam Member The pointer to the member field
+ * @param Name The name of the field in the shader
+ * @return The field descriptor, the offset will be filled by MakeShaderFields
+ */
+template <auto Member> constexpr ShaderField ShaderFieldOf(std::string_view Name) {
+	using Traits = ShaderMemberTraits<decltype(Member)>;
+
+	return {Name, ShaderTypeOf<typename Traits::Type>(), 0, &ShaderFieldRead<Member>};
+}
+
+/**
+ * Make the descriptor table of a structure, the fields are packed in the declaring order
+ * @param Fields The field descriptors made by ShaderFieldOf
+ * @return The descriptor table
+ */
+template <class... FieldType> constexpr auto MakeShaderFields(FieldType... Fields) {
+	std::array<ShaderField, sizeof...(FieldType)> table{Fields...};
+
+	int offset = 0;
+	for (auto &field : table) {
+		field.Offset = offset;
+		offset += ShaderPropertySize(field.Type);
+	}
+
+	return table;
+}
+
+/**
+ * The base of the uniform structure with compile-time field descriptors. The derived class only
+ * needs to provide a static constexpr function "ShaderFields" which returns the table made by
+ * MakeShaderFields, and the type name by Type()
+ * @tparam Derived The derived structure class
+ */
+template <class Derived> class ShaderStructure : public IShaderStructureUniform {
+public:
+	std::vector<std::string> PropertyList() override {
+		std::vector<std::string> list;
+		for (auto &field : Table()) {
+			list.emplace_back(field.Name);
+		}
+
+		return list;
+	}
+	std::map<std::string, std::string> PropertyValue() override {
+		std::map<std::string, std::string> value;
+		for (auto &field : Table()) {
+			float data[4];
+			field.Read(this, data);
+
+			std::string literal;
+			switch (field.Type) {
+			case ShaderPropertyType::Int:
+				literal = std::to_string(static_cast<int>(data[0]));
+				break;
+			case ShaderPropertyType::Float:
+				literal = std::to_string(data[0]);
+				break;
+			case ShaderPropertyType::Vec2:
+				literal = MathUniform::UniformVec2({data[0], data[1]});
+				break;
+			case ShaderPropertyType::Vec3:
+				literal = MathUniform::UniformVec3({data[0], data[1], data[2]});
+				break;
+			case ShaderPropertyType::Vec4:
+				literal = MathUniform::UniformVec4({data[0], data[1], data[2], data[3]});
+				break;
+			}
+			value.emplace(field.Name, std::move(literal));
+		}
+
+		return value;
+	}
+	std::vector<ShaderPropertyType> PropertyType() override {
+		std::vector<ShaderPropertyType> list;
+		for (auto &field : Table()) {
+			list.push_back(field.Type);
+		}
+
+		return list;
+	}
+	void PropertyData(float *Data) override {
+		for (auto &field : Table()) {
+			field.Read(this, Data + field.Offset);
+		}
+	}
+	[[nodiscard]] std::span<const ShaderField> Fields() const override {
+		return Table();
+	}
+
+private:
+	/**
+	 * Get the descriptor table of the derived structure
+	 * @return The descriptor table
+	 */
+	static const auto &Table() {
+		static constexpr auto table = Derived::ShaderFields();
+
+		return table;
+	}
+};
+} // namespace Vedo
@@ -1,18 +1,24 @@
+#include <include/render/VeBVH.h>
 #include <include/render/VeCamera.h>
 #include <include/render/VeObject.h>
+#include <include/render/VeRender.h>
+#include <include/shader/VeShaderCache.h>
 
 #include <glfw/glfw3.h>
 
 sk_sp<const GrGLInterface> GLInterface;
-sk_sp<SkShader> Shader;
+sk_sp<GrDirectContext> GLContext;
+std::unique_ptr<Vedo::Render> Renderer;
 
 #define WIDTH  640
 #define HEIGHT 480
 
 GLFWwindow *GLWindow;
 
+Vedo::ShaderDiskCache ProgramCache("./.vedo_cache");
+
 /**
- * Init OpenGL interface object
+ * Init OpenGL interface object and the Skia GPU context
  */
 void InitGLInterface();
 /**
@@ -45,6 +51,7 @@ int main() {
     camera.Width = WIDTH;
     camera.SPP = 200;
     camera.Depth = 50;
+    camera.Sampler = Vedo::SobolSampler;
 
     camera.FOV = 90;
     camera.LookFrom = Vedo::Vec3(13, 2, 3);
@@ -56,42 +63,53 @@ int main() {
 
     camera.Init();
 
+    Vedo::Material metal;
+    metal.Kind = Vedo::MetalMaterial;
+    metal.Albedo = Vedo::Vec3(43.f / 255.f, 45.f / 255.f, 48.f / 255.f);
+    metal.Fuzz = 2.f;
+
+    Vedo::MaterialTable materials;
+
     Vedo::Object sphere;
     sphere.Center = Vedo::Vec3(0, 0, 0);
     sphere.Radius = 7.5f;
-    sphere.Material = Vedo::MetalMaterial;
+    sphere.Material = materials.Add(metal);
     sphere.Shape = Vedo::SphereGeometry;
-    sphere.Albedo = Vedo::Vec3(43.f / 255.f, 45.f / 255.f, 48.f / 255.f);
-    sphere.Fuzz = 2.f;
 
     try {
         std::vector<Vedo::IShaderStructureUniform *> cameraUniform = {&camera};
-        std::vector<Vedo::IShaderStructureUniform *> objectUniform = {&sphere};
+
+        // The objects are walked through their BVH in the shader
+        auto bvh = Vedo::BVH::Make({&sphere});
 
         auto shader = Vedo::Shader::MakeFromFile("../shaders/path_tracing.sksl");
 
-        shader->BindUniform("u_seed", time(nullptr));
-        shader->BindUniform("u_SPP", int(camera.SPP));
         shader->BindUniform("u_Depth", int(camera.Depth));
-        shader->BindUniform("u_ObjectCount", objectUniform.size());
-        shader->BindUniformArray("u_camera", cameraUniform);
-        shader->BindUniformArray("u_object", objectUniform);
-
-        auto code = shader->MakeCode();
-        SkRuntimeEffect::Result effectResult = SkRuntimeEffect::MakeForShader(SkString(code));
-        sk_sp<SkRuntimeEffect> runtimeEffect = effectResult.effect;
-        Shader = runtimeEffect->makeShader(nullptr, {});
-
-        // Create an offscreen surface
-        const int width = 512, height = 512;
+        // Scene data are passed as packed uniforms, moving objects will not compile the shader again
+        shader->BindUniformArray("u_camera", cameraUniform, Vedo::ShaderUniformMode::Packed);
+        shader->BindUniformArray("u_material", materials.Uniforms(), Vedo::ShaderUniformMode::Packed);
+        shader->BindUniform("u_NodeLimit", bvh->NodeLimit());
+        shader->BindChild("u_bvh", bvh->MakeNodeShader());
+        shader->BindUniform("u_BottomNodeLimit", bvh->BottomNodeLimit());
+        shader->BindChild("u_blas", bvh->MakeBottomNodeShader());
 
     	InitWindow();
     	InitResource();
     	InitGLInterface();
 
-    	Draw(WIDTH, HEIGHT);
+        // Every pass renders 4 samples per pixel, the image converges to camera.SPP samples
+        Renderer = Vedo::Render::MakeProgressive(GLContext.get(), std::move(shader), camera, 4);
+
+    	// Every frame is presented, so the window is still redrawn after the image has converged,
+    	// and then it waits for the events instead of spinning
     	while (!glfwWindowShouldClose(GLWindow)) {
-    		glfwPollEvents();
+    		auto converging = Renderer->Progress();
+    		Draw(WIDTH, HEIGHT);
+    		if (converging) {
+    			glfwPollEvents();
+    		} else {
+    			glfwWaitEvents();
+    		}
     	}
     } catch (std::exception &e) {
         printf("Error occurred: %s.", e.what());
@@ -104,6 +122,10 @@ int main() {
 
 void InitGLInterface() {
 	GLInterface = GrGLMakeNativeInterface();
+
+	GrContextOptions contextOptions;
+	contextOptions.fPersistentCache = &ProgramCache;
+	GLContext = GrDirectContext::MakeGL(GLInterface, contextOptions);
 }
 void InitWindow() {
 	glfwSetErrorCallback(ErrorCallBack);
@@ -129,23 +151,20 @@ void FrameBufferCallBack(GLFWwindow *Window, int Width, int Height) {
 }
 void Draw(int Width, int Height) {
 	GrBackendRenderTarget glRenderTarget = {Width, Height, 0, 0, GrGLFramebufferInfo{.fFBOID = 0, .fFormat = GL_RGBA8}};
-	sk_sp<GrDirectContext> glContext = GrDirectContext::MakeGL(GLInterface);
 	SkColorType	   colorType = kRGBA_8888_SkColorType;
 	SkSurfaceProps property(SkSurfaceProps::Flags::kDynamicMSAA_Flag, SkPixelGeometry::kUnknown_SkPixelGeometry);
 
 	// In fact, we don't need to proc the render target destroying
 	auto glSurface =
-		SkSurface::MakeFromBackendRenderTarget(glContext.get(), glRenderTarget,
+		SkSurface::MakeFromBackendRenderTarget(GLContext.get(), glRenderTarget,
 											   kBottomLeft_GrSurfaceOrigin, colorType, nullptr, &property);
 
 	auto canvas = glSurface->getCanvas();
 	canvas->clear(SK_ColorBLACK);
-	SkPaint paint;
-	paint.setShader(Shader);
-	canvas->drawPaint(paint);
+	Renderer->Present(canvas);
 
 	canvas->flush();
-	glContext->flushAndSubmit();
+	GLContext->flushAndSubmit();
 
 	glfwSwapBuffers(GLWindow);
 }
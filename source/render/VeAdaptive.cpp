@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeAdaptive.cpp
+ * \brief The adaptive sampling of the progressive renders
+ */
+
+#include <include/render/VeAdaptive.h>
+#include <include/render/VeRender.h>
+
+#include <cmath>
+
+namespace Vedo {
+namespace {
+/**
+ * The luminance below it is taken as it by the threshold, so the black pixels still converge
+ */
+constexpr float MinLuminance = 0.01f;
+} // namespace
+
+std::unique_ptr<AdaptiveSampling> AdaptiveSampling::Make(int Width, int Height, float Threshold, int SamplePerPass,
+														 int SampleTarget) {
+	if (Threshold <= 0) {
+		return nullptr;
+	}
+
+	// The statistics are not a color, but they are read by the shader like an image
+	auto info		= SkImageInfo::Make(Width, Height, kRGBA_F32_SkColorType, kPremul_SkAlphaType);
+	auto statistics = SkSurface::MakeRaster(info);
+	if (statistics == nullptr) {
+		throw RenderCreateFailure("adaptive statistics surface");
+	}
+
+	return std::unique_ptr<AdaptiveSampling>(
+		new AdaptiveSampling(std::move(statistics), Threshold, SamplePerPass, SampleTarget));
+}
+AdaptiveSampling::AdaptiveSampling(sk_sp<SkSurface> Statistics, float Threshold, int SamplePerPass,
+								   int SampleTarget)
+	: _statistics(std::move(Statistics)), _threshold(Threshold), _samplePerPass(std::max(SamplePerPass, 1)),
+	  _sampleTarget(std::max(SampleTarget, 1)),
+	  _budget(static_cast<int64_t>(_statistics->width()) * _statistics->height() * _sampleTarget), _remaining(0),
+	  _sampleCount(0), _savedSample(0) {
+	Reset();
+}
+void AdaptiveSampling::Reset() {
+	_statistics->getCanvas()->clear(SK_ColorTRANSPARENT);
+	Prepare();
+
+	_remaining	 = _statistics->width() * _statistics->height();
+	_sampleCount = 0;
+	_savedSample = 0;
+}
+void AdaptiveSampling::Prepare() {
+	_statistics->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+	if (!_statistics->peekPixels(&_pixels)) {
+		throw RenderCreateFailure("adaptive statistics pixels");
+	}
+}
+void AdaptiveSampling::Accumulate(int X, int Y, float *Pixel, float Red, float Green, float Blue) {
+	auto statistic = static_cast<float *>(_pixels.writable_addr(X, Y));
+	auto count	   = statistic[2] + 1.f;
+
+	// Running average of the passes of this pixel, the image is opaque so premul does not change the color
+	auto blend = 1.f / count;
+	Pixel[0] += (Red - Pixel[0]) * blend;
+	Pixel[1] += (Green - Pixel[1]) * blend;
+	Pixel[2] += (Blue - Pixel[2]) * blend;
+	Pixel[3] = 1.f;
+
+	auto luminance = 0.2126f * Red + 0.7152f * Green + 0.0722f * Blue;
+	auto delta	   = luminance - statistic[0];
+	statistic[0] += delta * blend;
+	statistic[1] += delta * (luminance - statistic[0]);
+	statistic[2] = count;
+
+	// The variance of the passes over the count is the variance of the mean. The error is measured
+	// against the square root of the luminance, about the noise seen through the gamma of the display
+	auto sample = static_cast<int>(count) * _samplePerPass;
+	if (sample >= MaxScale * _sampleTarget) {
+		statistic[3] = 1.f;
+	} else if (sample >= MinSample && count > 1.f) {
+		auto error = std::sqrt(statistic[1] / ((count - 1.f) * count));
+		if (error <= _threshold * std::sqrt(std::max(statistic[0], MinLuminance))) {
+			statistic[3] = 1.f;
+		}
+	}
+}
+void AdaptiveSampling::Finish() {
+	// Every pixel sampled by the pass took the samples of a pass
+	_sampleCount += static_cast<int64_t>(_remaining) * _samplePerPass;
+
+	_remaining	 = 0;
+	_savedSample = 0;
+	for (int y = 0; y < _pixels.height(); ++y) {
+		auto row = static_cast<const float *>(_pixels.addr(0, y));
+		for (int x = 0; x < _pixels.width(); ++x) {
+			auto statistic = row + 4 * x;
+			if (statistic[3] == 0.f) {
+				++_remaining;
+			} else {
+				_savedSample += std::max(_sampleTarget - static_cast<int>(statistic[2]) * _samplePerPass, 0);
+			}
+		}
+	}
+}
+sk_sp<SkImage> AdaptiveSampling::Snapshot() {
+	return _statistics->makeImageSnapshot();
+}
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeBVH.cpp
+ * \brief The bounding volume hierarchy of the Vedo objects
+ */
+
+#include <include/render/VeBVH.h>
+
+#include <bit>
+#include <chrono>
+#include <latch>
+#include <thread>
+
+namespace Vedo {
+namespace {
+/**
+ * The subtrees with more primitives than it are split by the parallel binning on the calling thread
+ */
+constexpr int ParallelBinSize = 1 << 16;
+/**
+ * The subtrees with more primitives than it spawn their left child as another task
+ */
+constexpr int SubtreeTaskSize = 1 << 12;
+
+/**
+ * Get the count of the worker threads, 0 for the count of the cores
+ */
+int WorkerCount(int ThreadCount) {
+	return ThreadCount > 0 ? ThreadCount : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+}
+/**
+ * Get the bin of the centroid on the axis
+ */
+int BinOf(const Vec3 &Centroid, int Axis, const Bound &CentroidBound, int BinCount) {
+	auto extent = CentroidBound.Max[Axis] - CentroidBound.Min[Axis];
+	auto bin	= static_cast<int>(static_cast<float>(BinCount) * (Centroid[Axis] - CentroidBound.Min[Axis]) / extent);
+	return std::clamp(bin, 0, BinCount - 1);
+}
+} // namespace
+
+std::unique_ptr<BVH> BVH::Make(const std::vector<Object *> &Objects, int BinCount) {
+	return Make(MakePrimitives(Objects), BinCount, 1);
+}
+std::unique_ptr<BVH> BVH::MakeParallel(const std::vector<Object *> &Objects, int ThreadCount, int BinCount) {
+	return Make(MakePrimitives(Objects), BinCount, std::max(ThreadCount, 0));
+}
+std::unique_ptr<BVH> BVH::MakeParallel(std::span<const Object> Objects, int ThreadCount, int BinCount) {
+	return Make(MakePrimitives(Objects), BinCount, std::max(ThreadCount, 0));
+}
+sk_sp<SkShader> BVH::MakeNodeShader(const std::vector<BVHNode> &Nodes) {
+	// The indices are stored as floats, they are exact up to 2^24 nodes
+	std::vector<float> texels(Nodes.size() * NodeTexelCount * 4);
+	for (size_t index = 0; index < Nodes.size(); ++index) {
+		auto &node	 = Nodes[index];
+		auto *texel	 = texels.data() + index * NodeTexelCount * 4;
+		float data[] = {node.BoundMin.x,
+						node.BoundMin.y,
+						node.BoundMin.z,
+						static_cast<float>(node.Escape),
+						node.BoundMax.x,
+						node.BoundMax.y,
+						node.BoundMax.z,
+						static_cast<float>(node.Object),
+						static_cast<float>(node.Triangle),
+						static_cast<float>(node.Instance),
+						static_cast<float>(node.Material),
+						static_cast<float>(node.Root),
+						node.Translation.x,
+						node.Translation.y,
+						node.Translation.z,
+						node.InverseX.x,
+						node.InverseX.y,
+						node.InverseX.z,
+						node.InverseY.x,
+						node.InverseY.y,
+						node.InverseY.z,
+						node.InverseZ.x,
+						node.InverseZ.y,
+						node.InverseZ.z};
+		std::copy(std::begin(data), std::end(data), texel);
+	}
+
+	return MeshBuffer::MakeTextureShader(texels, Nodes.size() * NodeTexelCount);
+}
+std::unique_ptr<BVH> BVH::Make(std::vector<Primitive> Primitives, int BinCount, int ThreadCount,
+							   SkExecutor *Executor) {
+	auto bvh   = std::unique_ptr<BVH>(new BVH());
+	auto start = std::chrono::steady_clock::now();
+
+	bvh->_binCount	  = std::max(BinCount, 2);
+	bvh->_threadCount = ThreadCount;
+	if (Primitives.empty()) {
+		return bvh;
+	}
+
+	Builder context;
+	context.Primitives = std::move(Primitives);
+	context.BinCount   = bvh->_binCount;
+	context.ChunkCount = WorkerCount(ThreadCount);
+	context.Pending	   = 0;
+	context.Executor   = Executor;
+	if (Executor == nullptr) {
+		context.OwnedExecutor = MakeExecutor(ThreadCount);
+		context.Executor	  = context.OwnedExecutor.get();
+	}
+
+	auto count = static_cast<int>(context.Primitives.size());
+	bvh->_nodes.resize(count * 2 - 1);
+	bvh->BuildTop(context, 0, count, 0);
+
+	std::unique_lock lock(context.Lock);
+	context.Finished.wait(lock, [&]() { return context.Pending == 0; });
+
+	bvh->_buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	bvh->_buildCost = bvh->Cost();
+
+	return bvh;
+}
+std::unique_ptr<SkExecutor> BVH::MakeExecutor(int ThreadCount) {
+	if (ThreadCount == 1) {
+		return nullptr;
+	}
+
+	return SkExecutor::MakeFIFOThreadPool(WorkerCount(ThreadCount), false);
+}
+std::unique_ptr<BVH> BVH::MakeFromNodes(std::vector<BVHNode> Nodes) {
+	auto bvh		= std::unique_ptr<BVH>(new BVH());
+	bvh->_nodes		= std::move(Nodes);
+	bvh->_buildCost = bvh->Cost();
+
+	return bvh;
+}
+std::unique_ptr<BVH> BVH::MakeInstanced(const std::vector<Object *> &Objects, const std::vector<Instance *> &Instances,
+									   int ThreadCount, int BinCount) {
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<bool> prototypes(Objects.size(), false);
+	for (auto &instance : Instances) {
+		if (instance->Object < 0 || instance->Object >= static_cast<int>(Objects.size())) {
+			throw BVHInvalidInstance(std::to_string(instance->Object).c_str());
+		}
+		prototypes[instance->Object] = true;
+	}
+
+	auto bvh		  = std::unique_ptr<BVH>(new BVH());
+	bvh->_binCount	  = std::max(BinCount, 2);
+	bvh->_threadCount = std::max(ThreadCount, 0);
+	bvh->_roots.assign(Objects.size(), -1);
+
+	// Every prototype is built alone, then its leaves are renumbered to refer to the objects and the
+	// triangles of the scene, and its nodes are moved after the bottom level BVHs built before. The
+	// prototypes share one thread pool instead of starting a pool each
+	auto executor	 = MakeExecutor(bvh->_threadCount);
+	int triangleBase = 0;
+	for (size_t index = 0; index < Objects.size(); ++index) {
+		auto triangleCount = static_cast<int>(TriangleCount(*Objects[index]));
+		if (prototypes[index]) {
+			auto primitives = MakePrimitives(std::vector<Object *>{Objects[index]});
+			for (auto &primitive : primitives) {
+				primitive.Object = static_cast<int>(index);
+				primitive.Triangle += primitive.Triangle >= 0 ? triangleBase : 0;
+			}
+
+			auto bottom = Make(std::move(primitives), bvh->_binCount, bvh->_threadCount, executor.get());
+			if (!bottom->_nodes.empty()) {
+				auto root			= static_cast<int>(bvh->_bottomNodes.size());
+				bvh->_roots[index] = root;
+				for (auto &node : bottom->_nodes) {
+					node.Escape += root;
+					bvh->_bottomNodes.push_back(node);
+				}
+			}
+		}
+		triangleBase += triangleCount;
+	}
+
+	bvh->Update(Objects, Instances);
+	bvh->_buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	return bvh;
+}
+Bound BVH::ObjectBound(const Object &Target) {
+	if (Target.Shape == MeshGeometry) {
+		return Target.Geometry != nullptr ? Target.Geometry->MeshBound() : Bound::Empty();
+	}
+
+	auto radius = std::abs(Target.Radius);
+	auto extent = Vec3{radius, radius, radius};
+
+	return {Target.Center - extent, Target.Center + extent};
+}
+size_t BVH::TriangleCount(const Object &Target) {
+	if (Target.Shape != MeshGeometry || Target.Geometry == nullptr) {
+		return 0;
+	}
+
+	return Target.Geometry->TriangleCount();
+}
+sk_sp<SkShader> BVH::MakeNodeShader() const {
+	return MakeNodeShader(_nodes);
+}
+int BVH::NodeLimit() const {
+	return static_cast<int>(std::bit_ceil(std::max<size_t>(_nodes.size(), 1)));
+}
+sk_sp<SkShader> BVH::MakeBottomNodeShader() const {
+	return MakeNodeShader(_bottomNodes);
+}
+int BVH::BottomNodeLimit() const {
+	size_t largest = 1;
+	for (auto root : _roots) {
+		if (root >= 0) {
+			largest = std::max<size_t>(largest, _bottomNodes[root].Escape - root);
+		}
+	}
+
+	return static_cast<int>(std::bit_ceil(largest));
+}
+float BVH::Cost() const {
+	if (_nodes.empty()) {
+		return 0;
+	}
+
+	auto rootArea = Bound{_nodes.front().BoundMin, _nodes.front().BoundMax}.Area();
+	if (rootArea <= 0) {
+		return static_cast<float>(_nodes.size());
+	}
+
+	float area = 0;
+	for (auto &node : _nodes) {
+		area += Bound{node.BoundMin, node.BoundMax}.Area();
+	}
+
+	return area / rootArea;
+}
+void BVH::Refit(const std::vector<Object *> &Objects) {
+	// The leaves refer to the triangles by the number through all the meshes
+	std::vector<int> triangleBase(Objects.size());
+	int				 triangleCount = 0;
+	for (size_t index = 0; index < Objects.size(); ++index) {
+		triangleBase[index] = triangleCount;
+		triangleCount += static_cast<int>(TriangleCount(*Objects[index]));
+	}
+
+	// The children are always after their parent in depth-first order, so a reversed walk visits the
+	// children first. The left child is the next node, the right child is after the left subtree
+	for (int index = static_cast<int>(_nodes.size()) - 1; index >= 0; --index) {
+		auto &node = _nodes[index];
+
+		Bound box;
+		if (node.Triangle >= 0) {
+			box = Objects[node.Object]->Geometry->TriangleBound(node.Triangle - triangleBase[node.Object]);
+		} else if (node.Object >= 0) {
+			box = ObjectBound(*Objects[node.Object]);
+		} else {
+			auto &left	= _nodes[index + 1];
+			auto &right = _nodes[left.Escape];
+			box			= {left.BoundMin, left.BoundMax};
+			box.Expand(Bound{right.BoundMin, right.BoundMax});
+		}
+
+		node.BoundMin = box.Min;
+		node.BoundMax = box.Max;
+
+		// The materials of the objects may be changed along with their positions
+		if (node.Object >= 0) {
+			node.Material = Objects[node.Object]->Material;
+		}
+	}
+}
+bool BVH::Update(const std::vector<Object *> &Objects, float RebuildThreshold) {
+	size_t primitiveCount = 0;
+	for (auto &object : Objects) {
+		primitiveCount += object->Shape == MeshGeometry ? TriangleCount(*object) : 1;
+	}
+
+	auto sameCount = primitiveCount == 0 ? _nodes.empty() : _nodes.size() == primitiveCount * 2 - 1;
+	if (sameCount) {
+		Refit(Objects);
+		if (Cost() <= _buildCost * RebuildThreshold) {
+			return false;
+		}
+	}
+
+	auto rebuilt = Make(MakePrimitives(Objects), _binCount, _threadCount);
+	_nodes		 = std::move(rebuilt->_nodes);
+	_buildTime	 = rebuilt->_buildTime;
+	_buildCost	 = rebuilt->_buildCost;
+
+	return true;
+}
+void BVH::Update(const std::vector<Object *> &Objects, const std::vector<Instance *> &Instances) {
+	std::vector<InstanceNode> instanceNodes;
+	instanceNodes.reserve(Instances.size());
+	for (size_t index = 0; index < Instances.size(); ++index) {
+		instanceNodes.push_back(MakeInstanceNode(*Instances[index], static_cast<int>(index)));
+	}
+
+	auto rebuilt   = Make(MakeTopPrimitives(Objects, Instances), _binCount, _threadCount);
+	_nodes		   = std::move(rebuilt->_nodes);
+	_instanceNodes = std::move(instanceNodes);
+
+	// The shader reads the instance from its leaf instead of scanning all the instances
+	for (auto &node : _nodes) {
+		if (node.Instance < 0) {
+			continue;
+		}
+
+		auto &instance	 = _instanceNodes[node.Instance];
+		node.Root		 = instance.Root;
+		node.Translation = instance.Translation;
+		node.InverseX	 = instance.InverseX;
+		node.InverseY	 = instance.InverseY;
+		node.InverseZ	 = instance.InverseZ;
+	}
+	_buildTime = rebuilt->_buildTime;
+	_buildCost = rebuilt->_buildCost;
+}
+std::vector<BVH::Primitive> BVH::MakeTopPrimitives(const std::vector<Object *> &Objects,
+												   const std::vector<Instance *> &Instances) const {
+	std::vector<bool> prototypes(Objects.size(), false);
+	for (size_t index = 0; index < Objects.size() && index < _roots.size(); ++index) {
+		prototypes[index] = _roots[index] >= 0;
+	}
+
+	auto primitives = MakePrimitives(Objects, prototypes);
+	for (size_t index = 0; index < Instances.size(); ++index) {
+		auto &instance = *Instances[index];
+		auto  root	   = _roots[instance.Object];
+		if (root < 0) {
+			continue;
+		}
+
+		// The bound of the instance in the world contains the transformed corners of the bound of its prototype
+		auto &node	= _bottomNodes[root];
+		auto  bound = Bound::Empty();
+		for (int corner = 0; corner < 8; ++corner) {
+			auto point = instance.Transform.map((corner & 1) != 0 ? node.BoundMax.x : node.BoundMin.x,
+												(corner & 2) != 0 ? node.BoundMax.y : node.BoundMin.y,
+												(corner & 4) != 0 ? node.BoundMax.z : node.BoundMin.z, 1);
+			bound.Expand(Vec3{point.x, point.y, point.z});
+		}
+		// The material of the instance is written into its leaf, so the shader shades the hit by it
+		auto material = instance.Material >= 0 ? instance.Material : Objects[instance.Object]->Material;
+		primitives.push_back({bound, bound.Centroid(), instance.Object, -1, static_cast<int>(index), material});
+	}
+
+	return primitives;
+}
+InstanceNode BVH::MakeInstanceNode(const Instance &Target, int Index) const {
+	if (Target.Object < 0 || Target.Object >= static_cast<int>(_roots.size())) {
+		throw BVHInvalidInstance(std::to_string(Target.Object).c_str());
+	}
+
+	Matrix inverse;
+	if (!Target.Transform.invert(&inverse)) {
+		throw BVHSingularTransform(std::to_string(Index).c_str());
+	}
+
+	InstanceNode node;
+	node.Object		 = Target.Object;
+	node.Root		 = _roots[Target.Object];
+	node.Translation = {Target.Transform.rc(0, 3), Target.Transform.rc(1, 3), Target.Transform.rc(2, 3)};
+	node.InverseX	 = {inverse.rc(0, 0), inverse.rc(0, 1), inverse.rc(0, 2)};
+	node.InverseY	 = {inverse.rc(1, 0), inverse.rc(1, 1), inverse.rc(1, 2)};
+	node.InverseZ	 = {inverse.rc(2, 0), inverse.rc(2, 1), inverse.rc(2, 2)};
+
+	return node;
+}
+void BVH::BuildTop(Builder &Context, int Begin, int End, int Node) {
+	if (Context.Executor == nullptr || End - Begin <= ParallelBinSize) {
+		Spawn(Context, [this, &Context, Begin, End, Node]() { BuildSubtree(Context, Begin, End, Node); });
+
+		return;
+	}
+
+	// Every chunk measures and fills its own histogram, they are merged after all the chunks done
+	auto chunkCount = Context.ChunkCount;
+	auto chunkSize	= (End - Begin + chunkCount - 1) / chunkCount;
+
+	std::vector<Bound> boxes(chunkCount, Bound::Empty());
+	std::vector<Bound> centroidBounds(chunkCount, Bound::Empty());
+	std::latch		   measured(chunkCount);
+	for (int chunk = 0; chunk < chunkCount; ++chunk) {
+		Context.Executor->add([&, chunk]() {
+			auto first = std::min(Begin + chunk * chunkSize, End);
+			Measure(Context, first, std::min(first + chunkSize, End), boxes[chunk], centroidBounds[chunk]);
+
+			measured.count_down();
+		});
+	}
+	measured.wait();
+
+	auto box		   = Bound::Empty();
+	auto centroidBound = Bound::Empty();
+	for (int chunk = 0; chunk < chunkCount; ++chunk) {
+		box.Expand(boxes[chunk]);
+		centroidBound.Expand(centroidBounds[chunk]);
+	}
+	WriteNode(Context, Begin, End, Node, box);
+
+	std::vector<Histogram> histograms(chunkCount, Histogram(Context.BinCount * 3));
+	std::latch			   filled(chunkCount);
+	for (int chunk = 0; chunk < chunkCount; ++chunk) {
+		Context.Executor->add([&, chunk]() {
+			auto first = std::min(Begin + chunk * chunkSize, End);
+			Fill(Context, first, std::min(first + chunkSize, End), centroidBound, histograms[chunk]);
+
+			filled.count_down();
+		});
+	}
+	filled.wait();
+
+	auto &bins = histograms.front();
+	for (int chunk = 1; chunk < chunkCount; ++chunk) {
+		for (size_t bin = 0; bin < bins.size(); ++bin) {
+			bins[bin].Box.Expand(histograms[chunk][bin].Box);
+			bins[bin].Count += histograms[chunk][bin].Count;
+		}
+	}
+
+	auto middle = Partition(Context, Begin, End, centroidBound, bins);
+	BuildTop(Context, Begin, middle, Node + 1);
+	BuildTop(Context, middle, End, Node + 2 * (middle - Begin));
+}
+void BVH::BuildSubtree(Builder &Context, int Begin, int End, int Node) {
+	auto box		   = Bound::Empty();
+	auto centroidBound = Bound::Empty();
+	Measure(Context, Begin, End, box, centroidBound);
+	if (WriteNode(Context, Begin, End, Node, box)) {
+		return;
+	}
+
+	Histogram bins(Context.BinCount * 3);
+	Fill(Context, Begin, End, centroidBound, bins);
+
+	// The left subtree starts right after the node, the right subtree after the 2N - 1 nodes of the left
+	auto middle = Partition(Context, Begin, End, centroidBound, bins);
+	if (Context.Executor != nullptr && End - Begin > SubtreeTaskSize) {
+		Spawn(Context, [this, &Context, Begin, middle, Node]() { BuildSubtree(Context, Begin, middle, Node + 1); });
+	} else {
+		BuildSubtree(Context, Begin, middle, Node + 1);
+	}
+	BuildSubtree(Context, middle, End, Node + 2 * (middle - Begin));
+}
+void BVH::Spawn(Builder &Context, std::function<void()> Task) {
+	if (Context.Executor == nullptr) {
+		Task();
+
+		return;
+	}
+
+	++Context.Pending;
+	Context.Executor->add([&Context, Task = std::move(Task)]() {
+		Task();
+
+		// Count down under the lock, otherwise the waiting thread may see no pending task and destroy
+		// the builder before the notification
+		std::lock_guard lock(Context.Lock);
+		if (--Context.Pending == 0) {
+			Context.Finished.notify_all();
+		}
+	});
+}
+bool BVH::WriteNode(const Builder &Context, int Begin, int End, int Node, const Bound &Box) {
+	auto &node	  = _nodes[Node];
+	node.BoundMin = Box.Min;
+	node.BoundMax = Box.Max;
+	node.Escape	  = Node + 2 * (End - Begin) - 1;
+	node.Object	  = End - Begin == 1 ? Context.Primitives[Begin].Object : -1;
+	node.Triangle = End - Begin == 1 ? Context.Primitives[Begin].Triangle : -1;
+	node.Instance = End - Begin == 1 ? Context.Primitives[Begin].Instance : -1;
+	node.Material = End - Begin == 1 ? Context.Primitives[Begin].Material : -1;
+
+	// The instance leaves are filled by the instances after the build
+	node.Root		 = -1;
+	node.Translation = {};
+	node.InverseX	 = {};
+	node.InverseY	 = {};
+	node.InverseZ	 = {};
+
+	return End - Begin == 1;
+}
+void BVH::Measure(const Builder &Context, int Begin, int End, Bound &Box, Bound &CentroidBound) {
+	for (int count = Begin; count < End; ++count) {
+		Box.Expand(Context.Primitives[count].Box);
+		CentroidBound.Expand(Context.Primitives[count].Centroid);
+	}
+}
+void BVH::Fill(const Builder &Context, int Begin, int End, const Bound &CentroidBound, Histogram &Bins) {
+	auto binCount = Context.BinCount;
+	for (int axis = 0; axis < 3; ++axis) {
+		if (CentroidBound.Max[axis] - CentroidBound.Min[axis] <= 0) {
+			continue;
+		}
+
+		for (int count = Begin; count < End; ++count) {
+			auto &primitive = Context.Primitives[count];
+			auto &bin		= Bins[axis * binCount + BinOf(primitive.Centroid, axis, CentroidBound, binCount)];
+			bin.Box.Expand(primitive.Box);
+			++bin.Count;
+		}
+	}
+}
+int BVH::Partition(Builder &Context, int Begin, int End, const Bound &CentroidBound, const Histogram &Bins) {
+	auto binCount = Context.BinCount;
+
+	// The cost of a split is the area of each side weighted by its primitive count
+	auto			   bestCost = std::numeric_limits<float>::infinity();
+	int				   bestAxis = -1;
+	int				   bestBin	= 0;
+	std::vector<float> rightArea(binCount);
+	for (int axis = 0; axis < 3; ++axis) {
+		if (CentroidBound.Max[axis] - CentroidBound.Min[axis] <= 0) {
+			continue;
+		}
+
+		auto bins  = Bins.begin() + axis * binCount;
+		auto right = Bound::Empty();
+		for (int bin = binCount - 1; bin > 0; --bin) {
+			right.Expand(bins[bin].Box);
+			rightArea[bin] = right.Area();
+		}
+
+		auto left	   = Bound::Empty();
+		int	 leftCount = 0;
+		for (int bin = 0; bin < binCount - 1; ++bin) {
+			left.Expand(bins[bin].Box);
+			leftCount += bins[bin].Count;
+
+			auto rightCount = (End - Begin) - leftCount;
+			if (leftCount == 0 || rightCount == 0) {
+				continue;
+			}
+
+			auto cost = left.Area() * static_cast<float>(leftCount) + rightArea[bin + 1] * static_cast<float>(rightCount);
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin	 = bin;
+			}
+		}
+	}
+
+	if (bestAxis >= 0) {
+		auto middle =
+			std::partition(Context.Primitives.begin() + Begin, Context.Primitives.begin() + End,
+						   [&](const Primitive &Target) {
+							   return BinOf(Target.Centroid, bestAxis, CentroidBound, binCount) <= bestBin;
+						   });
+		return static_cast<int>(middle - Context.Primitives.begin());
+	}
+
+	// All the centroids are at the same point, any split is as good as the others
+	return Begin + (End - Begin) / 2;
+}
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeMaterial.cpp
+ * \brief The material table of the Vedo renderer
+ */
+
+#include <include/render/VeMaterial.h>
+
+namespace Vedo {
+int MaterialTable::Add(const Material &Value) {
+	auto [iterator, inserted] = _index.emplace(MakeKey(Value), Size());
+	if (inserted) {
+		_materials.push_back(Value);
+	}
+
+	return iterator->second;
+}
+void MaterialTable::Set(int Index, const Material &Value) {
+	if (Index < 0 || Index >= Size()) {
+		throw MaterialOutOfRange(std::to_string(Index).c_str());
+	}
+
+	// Another equal material may have been added after this one, only the key owned by this index
+	// is dropped
+	auto old = _index.find(MakeKey(_materials[Index]));
+	if (old != _index.end() && old->second == Index) {
+		_index.erase(old);
+	}
+
+	_materials[Index] = Value;
+	_index.emplace(MakeKey(Value), Index);
+}
+std::vector<Material *> MaterialTable::Uniforms() {
+	std::vector<Material *> uniforms;
+	uniforms.reserve(_materials.size());
+	for (auto &material : _materials) {
+		uniforms.push_back(&material);
+	}
+
+	return uniforms;
+}
+MaterialTable::Key MaterialTable::MakeKey(const Material &Value) {
+	return {Value.Kind, Value.Albedo.x, Value.Albedo.y, Value.Albedo.z, Value.Fuzz, Value.IndexRefraction};
+}
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeMesh.cpp
+ * \brief The triangle mesh of the Vedo objects
+ */
+
+#include <include/render/VeMesh.h>
+
+namespace Vedo {
+std::unique_ptr<Mesh> Mesh::Make(const std::vector<Vec3> &Vertices, const std::vector<uint32_t> &Indices) {
+	if (Indices.size() % 3 != 0) {
+		throw MeshInvalidIndexCount(std::to_string(Indices.size()).c_str());
+	}
+
+	auto mesh = std::unique_ptr<Mesh>(new Mesh());
+	mesh->_x.reserve(Vertices.size());
+	mesh->_y.reserve(Vertices.size());
+	mesh->_z.reserve(Vertices.size());
+	for (auto &vertex : Vertices) {
+		mesh->AddVertex(vertex);
+	}
+
+	mesh->_indices.reserve(Indices.size());
+	for (size_t index = 0; index < Indices.size(); index += 3) {
+		mesh->AddTriangle(Indices[index], Indices[index + 1], Indices[index + 2]);
+	}
+
+	return mesh;
+}
+std::unique_ptr<Mesh> Mesh::MakeView(std::span<const float> X, std::span<const float> Y, std::span<const float> Z,
+									 std::span<const uint32_t> Indices) {
+	// The renders read the vertices by the indices without any check, so a corrupt buffer is refused here
+	if (Y.size() != X.size() || Z.size() != X.size()) {
+		throw MeshInvalidVertexCount(std::to_string(X.size()).c_str());
+	}
+	if (Indices.size() % 3 != 0) {
+		throw MeshInvalidIndexCount(std::to_string(Indices.size()).c_str());
+	}
+	for (auto index : Indices) {
+		if (index >= X.size()) {
+			throw MeshInvalidIndex(std::to_string(index).c_str());
+		}
+	}
+
+	auto mesh		   = std::unique_ptr<Mesh>(new Mesh());
+	mesh->_owned	   = false;
+	mesh->_viewX	   = X;
+	mesh->_viewY	   = Y;
+	mesh->_viewZ	   = Z;
+	mesh->_viewIndices = Indices;
+
+	return mesh;
+}
+uint32_t Mesh::AddVertex(const Vec3 &Position) {
+	Own();
+	_x.push_back(Position.x);
+	_y.push_back(Position.y);
+	_z.push_back(Position.z);
+	ViewStorage();
+
+	return static_cast<uint32_t>(_x.size() - 1);
+}
+void Mesh::AddTriangle(uint32_t First, uint32_t Second, uint32_t Third) {
+	for (auto index : {First, Second, Third}) {
+		if (index >= VertexCount()) {
+			throw MeshInvalidIndex(std::to_string(index).c_str());
+		}
+	}
+
+	Own();
+	_indices.insert(_indices.end(), {First, Second, Third});
+	ViewStorage();
+}
+void Mesh::SetVertex(uint32_t Index, const Vec3 &Position) {
+	if (Index >= VertexCount()) {
+		throw MeshInvalidIndex(std::to_string(Index).c_str());
+	}
+
+	Own();
+	_x[Index] = Position.x;
+	_y[Index] = Position.y;
+	_z[Index] = Position.z;
+}
+void Mesh::Own() {
+	if (_owned) {
+		return;
+	}
+
+	_x.assign(_viewX.begin(), _viewX.end());
+	_y.assign(_viewY.begin(), _viewY.end());
+	_z.assign(_viewZ.begin(), _viewZ.end());
+	_indices.assign(_viewIndices.begin(), _viewIndices.end());
+	_owned = true;
+
+	ViewStorage();
+}
+void Mesh::ViewStorage() {
+	_viewX		 = _x;
+	_viewY		 = _y;
+	_viewZ		 = _z;
+	_viewIndices = _indices;
+}
+Bound Mesh::TriangleBound(size_t Index) const {
+	auto bound = Bound::Empty();
+	for (auto &vertex : Triangle(Index)) {
+		bound.Expand(vertex);
+	}
+
+	return bound;
+}
+Bound Mesh::MeshBound() const {
+	auto bound = Bound::Empty();
+	for (auto index : _viewIndices) {
+		bound.Expand(Vertex(index));
+	}
+
+	return bound;
+}
+std::optional<float> Mesh::Intersect(size_t Index, const Vec3 &Origin, const Vec3 &Direction, float TMin,
+									 float TMax) const {
+	// Permute the axes so that the ray travels along the largest axis as "z", then shear the
+	// triangle so the ray becomes the +z axis. The hit is decided by the signs of the 2D edge
+	// functions, which are the same for the shared edge of the neighbouring triangles
+	int axisZ = 0;
+	if (std::abs(Direction.y) > std::abs(Direction[axisZ])) {
+		axisZ = 1;
+	}
+	if (std::abs(Direction.z) > std::abs(Direction[axisZ])) {
+		axisZ = 2;
+	}
+	int axisX = (axisZ + 1) % 3;
+	int axisY = (axisX + 1) % 3;
+	if (Direction[axisZ] < 0) {
+		std::swap(axisX, axisY);
+	}
+
+	auto shearX = Direction[axisX] / Direction[axisZ];
+	auto shearY = Direction[axisY] / Direction[axisZ];
+	auto shearZ = 1.f / Direction[axisZ];
+
+	auto [first, second, third] = Triangle(Index);
+	auto a = first - Origin;
+	auto b = second - Origin;
+	auto c = third - Origin;
+
+	auto ax = a[axisX] - shearX * a[axisZ];
+	auto ay = a[axisY] - shearY * a[axisZ];
+	auto bx = b[axisX] - shearX * b[axisZ];
+	auto by = b[axisY] - shearY * b[axisZ];
+	auto cx = c[axisX] - shearX * c[axisZ];
+	auto cy = c[axisY] - shearY * c[axisZ];
+
+	auto u = cx * by - cy * bx;
+	auto v = ax * cy - ay * cx;
+	auto w = bx * ay - by * ax;
+
+	// The edge function rounded to zero is evaluated again in double precision, so a ray exactly on
+	// the edge is not lost by the rounding
+	if (u == 0 || v == 0 || w == 0) {
+		u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+		v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+		w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+	}
+	if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) {
+		return std::nullopt;
+	}
+
+	auto determinant = u + v + w;
+	if (determinant == 0) {
+		return std::nullopt;
+	}
+
+	auto t = (u * a[axisZ] + v * b[axisZ] + w * c[axisZ]) * shearZ / determinant;
+	if (t < TMin || t > TMax) {
+		return std::nullopt;
+	}
+
+	return t;
+}
+
+std::unique_ptr<MeshBuffer> MeshBuffer::Make(const std::vector<Object *> &Objects) {
+	auto buffer = std::unique_ptr<MeshBuffer>(new MeshBuffer());
+	for (auto &object : Objects) {
+		if (object->Shape != MeshGeometry || object->Geometry == nullptr) {
+			continue;
+		}
+
+		auto &mesh = *object->Geometry;
+		auto  base = static_cast<uint32_t>(buffer->_x.size());
+		buffer->_x.insert(buffer->_x.end(), mesh.X().begin(), mesh.X().end());
+		buffer->_y.insert(buffer->_y.end(), mesh.Y().begin(), mesh.Y().end());
+		buffer->_z.insert(buffer->_z.end(), mesh.Z().begin(), mesh.Z().end());
+		for (auto index : mesh.Indices()) {
+			buffer->_indices.push_back(base + index);
+		}
+	}
+
+	return buffer;
+}
+sk_sp<SkShader> MeshBuffer::MakeVertexShader() const {
+	std::vector<float> texels(_x.size() * 4);
+	for (size_t index = 0; index < _x.size(); ++index) {
+		texels[index * 4]	  = _x[index];
+		texels[index * 4 + 1] = _y[index];
+		texels[index * 4 + 2] = _z[index];
+		texels[index * 4 + 3] = 1.f;
+	}
+
+	return MakeTextureShader(texels, _x.size());
+}
+sk_sp<SkShader> MeshBuffer::MakeIndexShader() const {
+	std::vector<float> texels(TriangleCount() * 4);
+	for (size_t index = 0; index < TriangleCount(); ++index) {
+		texels[index * 4]	  = static_cast<float>(_indices[index * 3]);
+		texels[index * 4 + 1] = static_cast<float>(_indices[index * 3 + 1]);
+		texels[index * 4 + 2] = static_cast<float>(_indices[index * 3 + 2]);
+		texels[index * 4 + 3] = 1.f;
+	}
+
+	return MakeTextureShader(texels, TriangleCount());
+}
+sk_sp<SkShader> MeshBuffer::MakeTextureShader(const std::vector<float> &Texels, size_t Count) {
+	if (Count == 0) {
+		return SkShaders::Empty();
+	}
+
+	// The texels are read back exactly by the nearest sampling, without color space the values are
+	// not converted
+	auto width	= static_cast<int>(std::min<size_t>(Count, TextureWidth));
+	auto height = static_cast<int>((Count + TextureWidth - 1) / TextureWidth);
+	auto info	= SkImageInfo::Make(width, height, kRGBA_F32_SkColorType, kOpaque_SkAlphaType);
+
+	std::vector<float> pixels(static_cast<size_t>(width) * height * 4, 0.f);
+	std::copy(Texels.begin(), Texels.end(), pixels.begin());
+
+	auto image = SkImage::MakeRasterData(info, SkData::MakeWithCopy(pixels.data(), pixels.size() * sizeof(float)),
+										 info.minRowBytes());
+	if (image == nullptr) {
+		return SkShaders::Empty();
+	}
+
+	return image->makeShader(SkTileMode::kClamp, SkTileMode::kClamp, SkSamplingOptions(SkFilterMode::kNearest));
+}
+} // namespace Vedo
\ No newline at end of file
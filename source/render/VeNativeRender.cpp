@@ -0,0 +1,590 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeNativeRender.cpp
+ * \brief The native CPU render of Vedo
+ */
+
+#include <include/render/VeNativeRender.h>
+
+namespace Vedo {
+namespace {
+/**
+ * The rays of the packet sheared to +z for the watertight triangle test, the axis where the direction
+ * is the largest becomes z. It only depends on the directions, so it is shared by the triangles of a
+ * bounce. The axes are chosen in each lane since the rays may be along different axes
+ */
+struct Shear {
+	SIMDMask  AlongX;
+	SIMDMask  AlongY;
+	SIMDMask  Flip;
+	SIMDFloat X;
+	SIMDFloat Y;
+	SIMDFloat Z;
+};
+
+/**
+ * Permute the axes of the vector so that "z" is the axis along the ray, the same as Permute() in
+ * path_tracing.sksl
+ */
+SIMDVec3 Permute(const SIMDVec3 &Value, const SIMDMask &AlongX, const SIMDMask &AlongY, const SIMDMask &Flip) {
+	auto z	   = Select(AlongX, Value.X, Select(AlongY, Value.Y, Value.Z));
+	auto next  = Select(AlongX, Value.Y, Select(AlongY, Value.Z, Value.X));
+	auto after = Select(AlongX, Value.Z, Select(AlongY, Value.X, Value.Y));
+
+	return {Select(Flip, after, next), Select(Flip, next, after), z};
+}
+Shear MakeShear(const SIMDVec3 &Direction) {
+	auto absX = Abs(Direction.X);
+	auto absY = Abs(Direction.Y);
+	auto absZ = Abs(Direction.Z);
+
+	Shear shear;
+	shear.AlongX = (absY <= absX) & (absZ <= absX);
+	shear.AlongY = AndNot((absZ <= absY), shear.AlongX);
+
+	// Keep the winding of the triangle when the ray goes along the negative axis
+	auto permuted = Permute(Direction, shear.AlongX, shear.AlongY, SIMDMask::Broadcast(false));
+	shear.Flip	  = permuted.Z < SIMDFloat::Broadcast(0.f);
+	permuted	  = Permute(Direction, shear.AlongX, shear.AlongY, shear.Flip);
+
+	shear.Z = SIMDFloat::Broadcast(1.f) / permuted.Z;
+	shear.X = permuted.X * shear.Z;
+	shear.Y = permuted.Y * shear.Z;
+
+	return shear;
+}
+/**
+ * The watertight ray-triangle test of the packet against one triangle, the same as Mesh::Intersect
+ * without the fallback in double precision
+ * @return The lanes hit the triangle, the distance is written to T
+ */
+SIMDMask HitTriangle(const SIMDVec3 &Origin, const Shear &Ray, const std::array<Vec3, 3> &Triangle, SIMDFloat &T) {
+	const auto zero = SIMDFloat::Broadcast(0.f);
+
+	auto a = Permute(SIMDVec3::Broadcast(Triangle[0]) - Origin, Ray.AlongX, Ray.AlongY, Ray.Flip);
+	auto b = Permute(SIMDVec3::Broadcast(Triangle[1]) - Origin, Ray.AlongX, Ray.AlongY, Ray.Flip);
+	auto c = Permute(SIMDVec3::Broadcast(Triangle[2]) - Origin, Ray.AlongX, Ray.AlongY, Ray.Flip);
+
+	auto ax = a.X - Ray.X * a.Z;
+	auto ay = a.Y - Ray.Y * a.Z;
+	auto bx = b.X - Ray.X * b.Z;
+	auto by = b.Y - Ray.Y * b.Z;
+	auto cx = c.X - Ray.X * c.Z;
+	auto cy = c.Y - Ray.Y * c.Z;
+
+	auto u = cx * by - cy * bx;
+	auto v = ax * cy - ay * cx;
+	auto w = bx * ay - by * ax;
+
+	auto negative = (u < zero) | (v < zero) | (w < zero);
+	auto positive = (u > zero) | (v > zero) | (w > zero);
+
+	// The degenerated triangle makes the distance NaN, which fails any comparison of the caller
+	T = (u * a.Z + v * b.Z + w * c.Z) * Ray.Z / (u + v + w);
+
+	return AndNot(SIMDMask::Broadcast(true), negative & positive);
+}
+} // namespace
+
+std::unique_ptr<NativeRender> NativeRender::Make(const Camera &RenderCamera, const MaterialTable &Materials,
+												 std::vector<Object *> Objects, int SamplePerPass, int TileSize,
+												 int ThreadCount) {
+	// The same format as the raster render, so the images of the two paths can be compared
+	auto info		  = SkImageInfo::Make(static_cast<int>(RenderCamera.Width), static_cast<int>(RenderCamera.Height),
+										  kRGBA_F32_SkColorType, kPremul_SkAlphaType);
+	auto accumulation = SkSurface::MakeRaster(info);
+	if (accumulation == nullptr) {
+		throw RenderCreateFailure("native accumulation surface");
+	}
+
+	return std::unique_ptr<NativeRender>(new NativeRender(RenderCamera, Materials, std::move(Objects),
+														  std::move(accumulation), SamplePerPass, TileSize,
+														  ThreadCount));
+}
+std::unique_ptr<NativeRender> NativeRender::Make(const Camera &RenderCamera, const MaterialTable &Materials,
+												 std::vector<Object *> Objects, std::unique_ptr<BVH> Tree,
+												 int SamplePerPass, int TileSize, int ThreadCount) {
+	auto render	 = Make(RenderCamera, Materials, std::move(Objects), SamplePerPass, TileSize, ThreadCount);
+	render->_bvh = std::move(Tree);
+
+	return render;
+}
+std::unique_ptr<NativeRender> NativeRender::Make(const Camera &RenderCamera, const MaterialTable &Materials,
+												 std::vector<Object *> Objects, std::vector<Instance *> Instances,
+												 int SamplePerPass, int TileSize, int ThreadCount) {
+	auto render		   = Make(RenderCamera, Materials, std::move(Objects), SamplePerPass, TileSize, ThreadCount);
+	render->_instances = std::move(Instances);
+
+	return render;
+}
+NativeRender::NativeRender(const Camera &RenderCamera, const MaterialTable &Materials, std::vector<Object *> Objects,
+						   sk_sp<SkSurface> Accumulation, int SamplePerPass, int TileSize, int ThreadCount)
+	: _camera(&RenderCamera), _materials(&Materials), _objects(std::move(Objects)),
+	  _accumulation(std::move(Accumulation)), _executor(SkExecutor::MakeFIFOThreadPool(std::max(ThreadCount, 0), false)),
+	  _samplePerPass(std::max(SamplePerPass, 1)), _tileSize(std::max(TileSize, 1)), _pass(0),
+	  _random(std::random_device{}()), _sampler(static_cast<uint32_t>(_random())),
+	  _adaptive(AdaptiveSampling::Make(_accumulation->width(), _accumulation->height(),
+									   RenderCamera.AdaptiveThreshold, _samplePerPass,
+									   static_cast<int>(RenderCamera.SPP))) {
+	Reset();
+}
+void NativeRender::Reset() {
+	_accumulation->getCanvas()->clear(SK_ColorTRANSPARENT);
+	_pass = 0;
+
+	if (_adaptive != nullptr) {
+		_adaptive->Reset();
+	}
+}
+void NativeRender::Update() {
+	_sceneChanged = true;
+}
+bool NativeRender::Progress() {
+	if (Converged()) {
+		return false;
+	}
+
+	// A static scene is flattened and its BVH is built only once
+	if (_sceneChanged) {
+		BuildScene();
+		_sceneChanged = false;
+	}
+
+	// The seed of the pass is hashed with the pixels and the samples into the random streams, the
+	// sample points go on along the sequence through the passes
+	auto seed = static_cast<uint32_t>(_random());
+	_sampler.Generate(static_cast<int>(_camera->Sampler), Sample(), _samplePerPass, static_cast<int>(_camera->Depth));
+
+	// The tiles write the pixels directly, detach the snapshots taken before from the pixels first
+	_accumulation->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+	if (_adaptive != nullptr) {
+		_adaptive->Prepare();
+	}
+
+	SkPixmap pixels;
+	if (!_accumulation->peekPixels(&pixels)) {
+		throw RenderCreateFailure("native tile");
+	}
+
+	int columns = (pixels.width() + _tileSize - 1) / _tileSize;
+	int rows	= (pixels.height() + _tileSize - 1) / _tileSize;
+
+	std::latch done(columns * rows);
+	for (int row = 0; row < rows; ++row) {
+		for (int column = 0; column < columns; ++column) {
+			_executor->add([&, column, row]() {
+				auto region = SkIRect::MakeLTRB(column * _tileSize, row * _tileSize,
+												std::min((column + 1) * _tileSize, pixels.width()),
+												std::min((row + 1) * _tileSize, pixels.height()));
+				RenderTile(region, pixels, seed);
+
+				done.count_down();
+			});
+		}
+	}
+	done.wait();
+
+	if (_adaptive != nullptr) {
+		_adaptive->Finish();
+	}
+
+	++_pass;
+
+	return true;
+}
+void NativeRender::Converge() {
+	while (Progress()) {
+	}
+}
+void NativeRender::Present(SkCanvas *Canvas) {
+	Canvas->drawImage(Snapshot(), 0, 0);
+}
+sk_sp<SkImage> NativeRender::Snapshot() {
+	return _accumulation->makeImageSnapshot();
+}
+void NativeRender::Save(const std::string &Path) {
+	Render::SaveSurface(_accumulation.get(), Path);
+}
+void NativeRender::BuildScene() {
+	_scene			  = Scene();
+	int triangleCount = 0;
+	for (auto &object : _objects) {
+		if (object->Material < 0 || object->Material >= _materials->Size()) {
+			throw MaterialOutOfRange(std::to_string(object->Material).c_str());
+		}
+
+		_scene.Shape.push_back(object->Shape);
+		_scene.CenterX.push_back(object->Center.x);
+		_scene.CenterY.push_back(object->Center.y);
+		_scene.CenterZ.push_back(object->Center.z);
+		_scene.Radius.push_back(object->Radius);
+
+		_scene.Meshes.push_back(object->Shape == MeshGeometry ? object->Geometry : nullptr);
+		_scene.TriangleBase.push_back(triangleCount);
+		triangleCount += static_cast<int>(BVH::TriangleCount(*object));
+	}
+	for (auto &instance : _instances) {
+		if (instance->Material >= _materials->Size()) {
+			throw MaterialOutOfRange(std::to_string(instance->Material).c_str());
+		}
+	}
+	for (auto &material : _materials->Materials()) {
+		_scene.Kind.push_back(material.Kind);
+		_scene.AlbedoX.push_back(material.Albedo.x);
+		_scene.AlbedoY.push_back(material.Albedo.y);
+		_scene.AlbedoZ.push_back(material.Albedo.z);
+		_scene.Fuzz.push_back(material.Fuzz);
+		_scene.IndexRefraction.push_back(material.IndexRefraction);
+	}
+
+	// The BVH given to Make is taken as it is. After Update the moved objects refit the BVH instead
+	// of building it again, and the moved instances only build the top level BVH again
+	if (_bvh == nullptr) {
+		_bvh = _instances.empty() ? BVH::Make(_objects) : BVH::MakeInstanced(_objects, _instances);
+	} else if (_sceneBuilt && !_instances.empty()) {
+		_bvh->Update(_objects, _instances);
+	} else if (_sceneBuilt) {
+		_bvh->Update(_objects);
+	}
+	_sceneBuilt = true;
+}
+void NativeRender::RenderTile(const SkIRect &Region, const SkPixmap &Pixels, uint32_t Seed) {
+	const auto &camera = *_camera;
+
+	auto center		  = SIMDVec3::Broadcast(camera.Center);
+	auto pixel100Loc  = SIMDVec3::Broadcast(camera.Pixel100Loc);
+	auto pixelDeltaU  = SIMDVec3::Broadcast(camera.PixelDeltaU);
+	auto pixelDeltaV  = SIMDVec3::Broadcast(camera.PixelDeltaV);
+	auto deFocusDiskU = SIMDVec3::Broadcast(camera.DeFocusDiskU);
+	auto deFocusDiskV = SIMDVec3::Broadcast(camera.DeFocusDiskV);
+	auto blend		  = 1.f / static_cast<float>(_pass + 1);
+	auto half		  = SIMDFloat::Broadcast(0.5f);
+	auto sobol		  = static_cast<int>(camera.Sampler) == SobolSampler;
+
+	// The centers of the pixels traced by the pass, the same as the coordinates passed to the shader. The
+	// pixels stopped by the adaptive sampling are left out, so the packets of the noisy pixels stay full
+	std::vector<float> pixelX;
+	std::vector<float> pixelY;
+	pixelX.reserve(static_cast<size_t>(Region.width()) * Region.height());
+	pixelY.reserve(static_cast<size_t>(Region.width()) * Region.height());
+	for (int y = Region.fTop; y < Region.fBottom; ++y) {
+		for (int x = Region.fLeft; x < Region.fRight; ++x) {
+			if (_adaptive == nullptr || _adaptive->Active(x, y)) {
+				pixelX.push_back(static_cast<float>(x) + 0.5f);
+				pixelY.push_back(static_cast<float>(y) + 0.5f);
+			}
+		}
+	}
+
+	auto pixelCount = static_cast<int>(pixelX.size());
+	for (int first = 0; first < pixelCount; first += SIMDWidth) {
+		// The lanes beyond the pixels repeat the last pixel, they are not traced
+		int	  lanes = std::min(SIMDWidth, pixelCount - first);
+		float laneX[SIMDWidth];
+		float laneY[SIMDWidth];
+		for (int lane = 0; lane < SIMDWidth; ++lane) {
+			laneX[lane] = pixelX[first + std::min(lane, lanes - 1)];
+			laneY[lane] = pixelY[first + std::min(lane, lanes - 1)];
+		}
+
+		auto coordX = SIMDFloat::Load(laneX);
+		auto coordY = SIMDFloat::Load(laneY);
+		auto active = SIMDFloat::Sequence(0.f) < SIMDFloat::Broadcast(static_cast<float>(lanes));
+
+		SIMDVec3 color{SIMDFloat::Broadcast(0.f), SIMDFloat::Broadcast(0.f), SIMDFloat::Broadcast(0.f)};
+		for (int count = 0; count < _samplePerPass; ++count) {
+			// Every sample of every pass takes its own streams, the bounces go on along them. The Sobol
+			// sampler rotates the points of all the samples of a pixel by the same offsets instead
+			SIMDRandom random(coordX, coordY, sobol ? 0u : Seed, sobol ? 0u : static_cast<uint32_t>(count));
+
+			auto &point		  = _sampler.Point(count, 0);
+			auto  deltaX	  = random.Next(point.x) - half;
+			auto  deltaY	  = random.Next(point.y) - half;
+			auto  pixelSample = pixel100Loc + pixelDeltaU * (coordX + deltaX) + pixelDeltaV * (coordY + deltaY);
+
+			auto origin = center;
+			if (camera.DeFocusAngle > 0) {
+				auto disk = random.NextInUnitDisk(point.z, point.w);
+				origin	  = center + deFocusDiskU * disk.X + deFocusDiskV * disk.Y;
+			}
+
+			auto result = Trace(origin, pixelSample - origin, active, random, count);
+			color		= color + result;
+		}
+		color = color * SIMDFloat::Broadcast(1.f / static_cast<float>(_samplePerPass));
+
+		float red[SIMDWidth];
+		float green[SIMDWidth];
+		float blue[SIMDWidth];
+		color.X.Store(red);
+		color.Y.Store(green);
+		color.Z.Store(blue);
+
+		for (int lane = 0; lane < lanes; ++lane) {
+			auto x	   = static_cast<int>(laneX[lane]);
+			auto y	   = static_cast<int>(laneY[lane]);
+			auto pixel = static_cast<float *>(Pixels.writable_addr(x, y));
+			if (_adaptive != nullptr) {
+				_adaptive->Accumulate(x, y, pixel, red[lane], green[lane], blue[lane]);
+
+				continue;
+			}
+
+			// Running average of the passes, the image is opaque so premul does not change the color
+			pixel[0] += (red[lane] - pixel[0]) * blend;
+			pixel[1] += (green[lane] - pixel[1]) * blend;
+			pixel[2] += (blue[lane] - pixel[2]) * blend;
+			pixel[3] = 1.f;
+		}
+	}
+}
+SIMDVec3 NativeRender::Trace(SIMDVec3 Origin, SIMDVec3 Direction, SIMDMask Active, SIMDRandom &Random,
+							 int Sample) const {
+	const auto zero = SIMDFloat::Broadcast(0.f);
+	const auto one	= SIMDFloat::Broadcast(1.f);
+	const auto tMin = SIMDFloat::Broadcast(0.001f);
+	const auto tMax = SIMDFloat::Broadcast(9999999.f);
+
+	SIMDVec3 result{one, one, one};
+
+	auto &nodes		= _bvh->Nodes();
+	int	  nodeCount = static_cast<int>(nodes.size());
+	for (int depth = static_cast<int>(_camera->Depth); depth > 0 && Active.Any(); --depth) {
+		// The distance of the closest hit of each lane, the nodes and the primitives beyond it are skipped
+		auto	 closest	 = tMax;
+		auto	 hit		 = SIMDMask::Broadcast(false);
+		auto	 hitMaterial = zero;
+		SIMDVec3 hitNormal{zero, zero, zero};
+
+		// Test the primitive of a leaf, the lanes hitting it closer than "closest" take the distance and the
+		// normal, which is not unit yet
+		auto hitLeaf = [&](const BVHNode &Leaf, const SIMDVec3 &RayOrigin, const SIMDVec3 &RayDirection,
+						   const Shear &RayShear, const SIMDMask &Lanes, SIMDVec3 &Normal) {
+			auto object = Leaf.Object;
+			if (Leaf.Triangle >= 0) {
+				auto	  triangle = _scene.Meshes[object]->Triangle(Leaf.Triangle - _scene.TriangleBase[object]);
+				SIMDFloat t;
+
+				auto newHit = HitTriangle(RayOrigin, RayShear, triangle, t) & (t >= tMin) & (t < closest) & Lanes;
+				auto normal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]);
+				closest		= Select(newHit, t, closest);
+				Normal		= Select(newHit, SIMDVec3::Broadcast(normal), Normal);
+
+				return newHit;
+			}
+			if (_scene.Shape[object] != SphereGeometry) {
+				return SIMDMask::Broadcast(false);
+			}
+
+			SIMDVec3 center{SIMDFloat::Broadcast(_scene.CenterX[object]), SIMDFloat::Broadcast(_scene.CenterY[object]),
+							SIMDFloat::Broadcast(_scene.CenterZ[object])};
+			auto	 radius = SIMDFloat::Broadcast(_scene.Radius[object]);
+			auto	 origin = RayOrigin - center;
+			auto	 a		= Dot(RayDirection, RayDirection);
+			auto	 halfB	= Dot(origin, RayDirection);
+			auto	 c		= Dot(origin, origin) - radius * radius;
+			auto	 delta	= halfB * halfB - a * c;
+
+			auto sqrtDelta = Sqrt(Max(delta, zero));
+			auto nearRoot  = (-halfB - sqrtDelta) / a;
+			auto farRoot   = (-halfB + sqrtDelta) / a;
+			auto nearValid = (nearRoot >= tMin) & (nearRoot < closest);
+			auto farValid  = (farRoot >= tMin) & (farRoot < closest);
+
+			auto newHit = (delta >= zero) & (nearValid | farValid) & Lanes;
+			auto root	= Select(nearValid, nearRoot, farRoot);
+			closest		= Select(newHit, root, closest);
+			Normal		= Select(newHit, origin + RayDirection * root, Normal);
+
+			return newHit;
+		};
+
+		// Walk the nodes in [First, End) in depth-first order like the shader, a node is entered when any
+		// lane of the packet hits its bound before its closest hit. The distance along the ray moved into
+		// the space of an instance is the same as in the world, so "closest" is shared by the two levels
+		auto walk = [&](const std::vector<BVHNode> &Nodes, int First, int End, const SIMDVec3 &RayOrigin,
+						const SIMDVec3 &RayDirection, const SIMDMask &Lanes, auto &&Leaf) {
+			SIMDVec3 inverseDirection{one / RayDirection.X, one / RayDirection.Y, one / RayDirection.Z};
+
+			for (int index = First; index < End;) {
+				auto &node = Nodes[index];
+
+				auto t0X   = (SIMDFloat::Broadcast(node.BoundMin.x) - RayOrigin.X) * inverseDirection.X;
+				auto t1X   = (SIMDFloat::Broadcast(node.BoundMax.x) - RayOrigin.X) * inverseDirection.X;
+				auto t0Y   = (SIMDFloat::Broadcast(node.BoundMin.y) - RayOrigin.Y) * inverseDirection.Y;
+				auto t1Y   = (SIMDFloat::Broadcast(node.BoundMax.y) - RayOrigin.Y) * inverseDirection.Y;
+				auto t0Z   = (SIMDFloat::Broadcast(node.BoundMin.z) - RayOrigin.Z) * inverseDirection.Z;
+				auto t1Z   = (SIMDFloat::Broadcast(node.BoundMax.z) - RayOrigin.Z) * inverseDirection.Z;
+				auto tNear = Max(Max(Min(t0X, t1X), Min(t0Y, t1Y)), Max(Min(t0Z, t1Z), tMin));
+				auto tFar  = Min(Min(Max(t0X, t1X), Max(t0Y, t1Y)), Min(Max(t0Z, t1Z), closest));
+
+				// The far distance is scaled up by the rounding error like the shader, so the ray grazing
+				// the bound of a flat triangle is never lost
+				auto boundHit = (tNear <= tFar * SIMDFloat::Broadcast(1.0000004f)) & Lanes;
+				if (!boundHit.Any()) {
+					index = node.Escape;
+
+					continue;
+				}
+				if (node.Object < 0) {
+					++index;
+
+					continue;
+				}
+
+				Leaf(node, boundHit);
+				index = node.Escape;
+			}
+		};
+
+		// The instance leaf moves the rays into the space of its prototype and walks the bottom level BVH
+		// of the prototype, the distance is kept since the direction is not normalized
+		auto shear	 = MakeShear(Direction);
+		auto topLeaf = [&](const BVHNode &Leaf, const SIMDMask &Lanes) {
+			SIMDVec3 normal{zero, zero, zero};
+
+			auto newHit = SIMDMask::Broadcast(false);
+			if (Leaf.Instance < 0) {
+				newHit = hitLeaf(Leaf, Origin, Direction, shear, Lanes, normal);
+			} else {
+				auto &instance = _bvh->InstanceNodes()[Leaf.Instance];
+				auto &bottom   = _bvh->BottomNodes();
+				auto  rowX	   = SIMDVec3::Broadcast(instance.InverseX);
+				auto  rowY	   = SIMDVec3::Broadcast(instance.InverseY);
+				auto  rowZ	   = SIMDVec3::Broadcast(instance.InverseZ);
+
+				auto	 offset = Origin - SIMDVec3::Broadcast(instance.Translation);
+				SIMDVec3 localOrigin{Dot(rowX, offset), Dot(rowY, offset), Dot(rowZ, offset)};
+				SIMDVec3 localDirection{Dot(rowX, Direction), Dot(rowY, Direction), Dot(rowZ, Direction)};
+				auto	 localShear = MakeShear(localDirection);
+
+				walk(bottom, instance.Root, bottom[instance.Root].Escape, localOrigin, localDirection, Lanes,
+					 [&](const BVHNode &BottomLeaf, const SIMDMask &BottomLanes) {
+						 newHit = newHit | hitLeaf(BottomLeaf, localOrigin, localDirection, localShear, BottomLanes,
+												   normal);
+					 });
+				normal = rowX * normal.X + rowY * normal.Y + rowZ * normal.Z;
+			}
+
+			hitNormal	= Select(newHit, normal, hitNormal);
+			hitMaterial = Select(newHit, SIMDFloat::Broadcast(static_cast<float>(Leaf.Material)), hitMaterial);
+			hit			= hit | newHit;
+		};
+		walk(nodes, 0, nodeCount, Origin, Direction, Active, topLeaf);
+
+		auto miss = AndNot(Active, hit);
+		if (miss.Any()) {
+			auto unitDirection = Normalize(Direction);
+			auto a			   = SIMDFloat::Broadcast(0.5f) * (unitDirection.Y + one);
+			auto skybox		   = SIMDVec3{one - a * SIMDFloat::Broadcast(0.5f), one - a * SIMDFloat::Broadcast(0.3f), one};
+			result			   = Select(miss, result * skybox, result);
+			Active			   = Active & hit;
+		}
+		if (!Active.Any()) {
+			break;
+		}
+
+		// Gather the materials of the hit objects into lanes
+		float laneMaterial[SIMDWidth];
+		float albedoX[SIMDWidth], albedoY[SIMDWidth], albedoZ[SIMDWidth];
+		float fuzz[SIMDWidth], indexRefraction[SIMDWidth];
+		float metal[SIMDWidth], dielectric[SIMDWidth];
+		hitMaterial.Store(laneMaterial);
+		for (int lane = 0; lane < SIMDWidth; ++lane) {
+			auto index			  = Active.Lane(lane) ? static_cast<int>(laneMaterial[lane]) : 0;
+			albedoX[lane]		  = _scene.AlbedoX[index];
+			albedoY[lane]		  = _scene.AlbedoY[index];
+			albedoZ[lane]		  = _scene.AlbedoZ[index];
+			fuzz[lane]			  = _scene.Fuzz[index];
+			indexRefraction[lane] = _scene.IndexRefraction[index];
+			metal[lane]			  = _scene.Kind[index] == MetalMaterial ? 1.f : 0.f;
+			dielectric[lane]	  = _scene.Kind[index] == DielectricMaterial ? 1.f : 0.f;
+		}
+
+		SIMDVec3 albedo{SIMDFloat::Load(albedoX), SIMDFloat::Load(albedoY), SIMDFloat::Load(albedoZ)};
+		auto	 isMetal	  = SIMDFloat::Load(metal) > zero;
+		auto	 isDielectric = SIMDFloat::Load(dielectric) > zero;
+
+		// The numbers are taken by every lane in every bounce, so the streams stay in step
+		auto &bounce  = _sampler.Point(Sample, 1 + static_cast<int>(_camera->Depth) - depth);
+		auto  scatter = Random.NextUnitVector(bounce.x, bounce.y);
+		auto  chance  = Random.Next(bounce.z);
+
+		// Shade the closest hit once, the normal of the triangle is the cross product of its edges and the
+		// normal of the sphere is not divided by the radius, they are normalized here
+		auto point	= Origin + Direction * closest;
+		auto normal = Select(Active, Normalize(hitNormal), SIMDVec3{zero, zero, one});
+		auto front	= Dot(Direction, normal) < zero;
+		normal		= Select(front, normal, -normal);
+
+		// The same dispatch as Scatter() of the shader, the lanes of the other materials are Lambert.
+		// The terms shared by the materials are computed once for the packet, the refraction is only
+		// computed when a lane hits a dielectric
+		auto unitDirection = Normalize(Direction);
+		auto reflected	   = Reflect(unitDirection, normal);
+		auto diffuse	   = normal + scatter;
+		diffuse			   = Select(Dot(diffuse, diffuse) < SIMDFloat::Broadcast(1e-8f), normal, diffuse);
+
+		auto scattered = Select(isMetal, reflected + scatter * SIMDFloat::Load(fuzz), diffuse);
+		if ((Active & isDielectric).Any()) {
+			// The Schlick approximation of the reflectance
+			auto ior		 = SIMDFloat::Load(indexRefraction);
+			auto ratio		 = Select(front, one / ior, ior);
+			auto cosine		 = Min(Dot(-unitDirection, normal), one);
+			auto base		 = (one - ratio) / (one + ratio);
+			auto r0			 = base * base;
+			auto grazing	 = one - cosine;
+			auto grazing2	 = grazing * grazing;
+			auto reflectance = r0 + (one - r0) * grazing2 * grazing2 * grazing;
+
+			auto refracted = Refract(unitDirection, normal, ratio);
+			auto mirror	   = (Dot(refracted, refracted) <= zero) | (reflectance > chance);
+			scattered	   = Select(isDielectric, Select(mirror, reflected, refracted), scattered);
+			albedo		   = Select(isDielectric, SIMDVec3{one, one, one}, albedo);
+		}
+
+		Direction = Select(Active, scattered, Direction);
+		Origin	  = Select(Active, point, Origin);
+		result	  = Select(Active, result * albedo, result);
+
+		// The fuzzed reflection pointing under the surface is absorbed like the shader
+		auto absorbed = Active & isMetal & (Dot(scattered, normal) <= zero);
+		result		  = Select(absorbed, SIMDVec3{zero, zero, zero}, result);
+		Active		  = AndNot(Active, absorbed);
+
+		// Russian roulette like the shader, the lanes stopped by it are black and leave the packet, the
+		// survivors are scaled up by the probability
+		if (static_cast<float>(_camera->Depth) + 1.f - static_cast<float>(depth) >= _camera->RouletteDepth) {
+			auto survive = Min(Max(Max(result.X, result.Y), result.Z) * SIMDFloat::Broadcast(4.f), one);
+			auto stopped = Active & (Random.Next(bounce.w) >= survive);
+			result		 = Select(Active, result * (one / survive), result);
+			result		 = Select(stopped, SIMDVec3{zero, zero, zero}, result);
+			Active		 = AndNot(Active, stopped);
+		}
+	}
+
+	// The rays still bouncing when the depth runs out are black
+	return Select(Active, SIMDVec3{zero, zero, zero}, result);
+}
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeObjLoader.cpp
+ * \brief The loader of the Wavefront OBJ meshes
+ */
+
+#include <include/render/VeObjLoader.h>
+
+#include <charconv>
+#include <fstream>
+#include <latch>
+#include <thread>
+
+namespace Vedo {
+namespace {
+/**
+ * The text smaller than it is parsed by a single chunk
+ */
+constexpr size_t MinimalChunkSize = 1 << 20;
+
+bool IsSpace(char Character) {
+	return Character == ' ' || Character == '\t' || Character == '\r';
+}
+const char *SkipSpace(const char *Cursor, const char *End) {
+	while (Cursor < End && IsSpace(*Cursor)) {
+		++Cursor;
+	}
+
+	return Cursor;
+}
+const char *SkipToken(const char *Cursor, const char *End) {
+	while (Cursor < End && !IsSpace(*Cursor)) {
+		++Cursor;
+	}
+
+	return Cursor;
+}
+const char *LineEnd(const char *Cursor, const char *End) {
+	auto end = static_cast<const char *>(memchr(Cursor, '\n', End - Cursor));
+	return end == nullptr ? End : end;
+}
+/**
+ * Whether the line starts with the statement, the cursor is moved after it
+ */
+bool ReadStatement(const char *&Cursor, const char *End, char Statement) {
+	if (End - Cursor >= 2 && Cursor[0] == Statement && IsSpace(Cursor[1])) {
+		Cursor += 2;
+
+		return true;
+	}
+
+	return false;
+}
+[[noreturn]] void Fail(const char *Line, const char *End) {
+	while (End > Line && IsSpace(End[-1])) {
+		--End;
+	}
+
+	throw ObjParseFailure(std::string(Line, std::min<size_t>(End - Line, 64)).c_str());
+}
+} // namespace
+
+std::unique_ptr<Mesh> ObjLoader::Load(const std::string &Path, int ThreadCount) {
+	std::ifstream file(Path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		throw ObjOpenFailure(Path.c_str());
+	}
+
+	std::string text(static_cast<size_t>(file.tellg()), '\0');
+	file.seekg(0);
+	if (!file.read(text.data(), static_cast<std::streamsize>(text.size()))) {
+		throw ObjOpenFailure(Path.c_str());
+	}
+
+	return Parse(text, ThreadCount);
+}
+std::unique_ptr<Mesh> ObjLoader::Parse(std::string_view Text, int ThreadCount) {
+	auto threadCount = ThreadCount > 0 ? ThreadCount : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+	auto chunkCount	 = static_cast<int>(std::clamp<size_t>(Text.size() / MinimalChunkSize, 1, threadCount * 4));
+
+	// Cut the chunks at the line boundaries
+	std::vector<Chunk> chunks;
+	auto			   begin = Text.data();
+	auto			   end	 = Text.data() + Text.size();
+	for (int index = 1; index <= chunkCount && begin < end; ++index) {
+		// The previous chunk may have passed the proportional cut, the chunk still ends at a line end
+		auto cut = index == chunkCount ? end : Text.data() + Text.size() * index / chunkCount;
+		cut		 = LineEnd(std::max(cut, begin), end);
+		cut		 = cut < end ? cut + 1 : end;
+
+		Chunk chunk;
+		chunk.Begin = begin;
+		chunk.End	= cut;
+		chunks.push_back(chunk);
+
+		begin = cut;
+	}
+
+	auto run = [&](auto Task) {
+		if (threadCount == 1 || chunks.size() == 1) {
+			for (auto &chunk : chunks) {
+				Task(chunk);
+			}
+		} else {
+			auto	   executor = SkExecutor::MakeFIFOThreadPool(threadCount, false);
+			std::latch done(static_cast<ptrdiff_t>(chunks.size()));
+			for (auto &chunk : chunks) {
+				executor->add([&]() {
+					try {
+						Task(chunk);
+					} catch (...) {
+						chunk.Error = std::current_exception();
+					}
+
+					done.count_down();
+				});
+			}
+			done.wait();
+		}
+
+		for (auto &chunk : chunks) {
+			if (chunk.Error) {
+				std::rethrow_exception(chunk.Error);
+			}
+		}
+	};
+
+	run([](Chunk &Target) { Count(Target); });
+
+	size_t vertexCount	 = 0;
+	size_t triangleCount = 0;
+	for (auto &chunk : chunks) {
+		chunk.FirstVertex	= vertexCount;
+		chunk.FirstTriangle = triangleCount;
+		vertexCount += chunk.VertexCount;
+		triangleCount += chunk.TriangleCount;
+	}
+
+	auto mesh = Mesh::Make();
+	mesh->_x.resize(vertexCount);
+	mesh->_y.resize(vertexCount);
+	mesh->_z.resize(vertexCount);
+	mesh->_indices.resize(triangleCount * 3);
+
+	run([&](Chunk &Target) { Fill(Target, *mesh); });
+	mesh->ViewStorage();
+
+	return mesh;
+}
+void ObjLoader::Count(Chunk &Target) {
+	for (auto line = Target.Begin; line < Target.End;) {
+		auto end	= LineEnd(line, Target.End);
+		auto cursor = SkipSpace(line, end);
+		if (ReadStatement(cursor, end, 'v')) {
+			++Target.VertexCount;
+		} else if (ReadStatement(cursor, end, 'f')) {
+			size_t corners = 0;
+			for (cursor = SkipSpace(cursor, end); cursor < end; cursor = SkipSpace(SkipToken(cursor, end), end)) {
+				++corners;
+			}
+			Target.TriangleCount += corners >= 3 ? corners - 2 : 0;
+		}
+
+		line = end + 1;
+	}
+}
+void ObjLoader::Fill(const Chunk &Target, Mesh &Output) {
+	auto x		 = Output._x.data() + Target.FirstVertex;
+	auto y		 = Output._y.data() + Target.FirstVertex;
+	auto z		 = Output._z.data() + Target.FirstVertex;
+	auto indices = Output._indices.data() + Target.FirstTriangle * 3;
+
+	auto	vertexCount = static_cast<int64_t>(Output._x.size());
+	int64_t vertex		= static_cast<int64_t>(Target.FirstVertex);
+	for (auto line = Target.Begin; line < Target.End;) {
+		auto end	= LineEnd(line, Target.End);
+		auto cursor = SkipSpace(line, end);
+		if (ReadStatement(cursor, end, 'v')) {
+			float position[3];
+			for (auto &value : position) {
+				cursor = SkipSpace(cursor, end);
+				if (cursor < end && *cursor == '+') {
+					++cursor;
+				}
+
+				auto [next, error] = std::from_chars(cursor, end, value);
+				if (error != std::errc()) {
+					Fail(line, end);
+				}
+				cursor = next;
+			}
+
+			*x++ = position[0];
+			*y++ = position[1];
+			*z++ = position[2];
+			++vertex;
+		} else if (ReadStatement(cursor, end, 'f')) {
+			// The polygon is split into a fan around its first corner, the texture and the normal
+			// indices after "/" are skipped. The negative index counts back from the last vertex
+			uint32_t first	  = 0;
+			uint32_t previous = 0;
+			int		 corner	  = 0;
+			for (cursor = SkipSpace(cursor, end); cursor < end; cursor = SkipSpace(SkipToken(cursor, end), end)) {
+				int64_t index		 = 0;
+				auto [next, error] = std::from_chars(cursor, end, index);
+				if (error != std::errc() || index == 0) {
+					Fail(line, end);
+				}
+				cursor = next;
+
+				index = index > 0 ? index - 1 : vertex + index;
+				if (index < 0 || index >= vertexCount) {
+					Fail(line, end);
+				}
+
+				auto current = static_cast<uint32_t>(index);
+				if (corner == 0) {
+					first = current;
+				} else if (corner >= 2) {
+					*indices++ = first;
+					*indices++ = previous;
+					*indices++ = current;
+				}
+				previous = current;
+				++corner;
+			}
+		}
+
+		line = end + 1;
+	}
+}
+} // namespace Vedo
\ No newline at end of file
@@ -23,4 +23,222 @@
 /**
  * \file VeRender.cpp
  * \brief The render class in Vedo
- */
\ No newline at end of file
+ */
+
+#include <include/render/VeRender.h>
+
+namespace Vedo {
+std::unique_ptr<Render> Render::MakeProgressive(GrRecordingContext *Context, std::unique_ptr<Shader> RenderShader,
+												const Camera &RenderCamera, int SamplePerPass) {
+	// The passes are blended in float format, 8-bit color can not hold the running average. The pass n
+	// is blended at the alpha of 1 / n, which falls below the 10-bit mantissa of F16 after a few
+	// hundred passes, so F32 is taken whenever the context can render into it
+	auto colorType = Context->colorTypeSupportedAsSurface(kRGBA_F32_SkColorType) ? kRGBA_F32_SkColorType
+																				 : kRGBA_F16_SkColorType;
+	auto info	   = SkImageInfo::Make(static_cast<int>(RenderCamera.Width), static_cast<int>(RenderCamera.Height),
+									   colorType, kPremul_SkAlphaType);
+	auto accumulation = SkSurface::MakeRenderTarget(Context, SkBudgeted::kNo, info);
+	if (accumulation == nullptr) {
+		throw RenderCreateFailure("accumulation surface");
+	}
+
+	return std::unique_ptr<Render>(
+		new Render(std::move(RenderShader), std::move(accumulation), RenderCamera, SamplePerPass));
+}
+std::unique_ptr<Render> Render::MakeRaster(std::unique_ptr<Shader> RenderShader, const Camera &RenderCamera,
+										   int SamplePerPass, SkColorType ColorType) {
+	if (ColorType != kRGBA_F16_SkColorType && ColorType != kRGBA_F32_SkColorType) {
+		throw RenderCreateFailure("raster surface in a non-float color type");
+	}
+
+	auto info		  = SkImageInfo::Make(static_cast<int>(RenderCamera.Width), static_cast<int>(RenderCamera.Height),
+										  ColorType, kPremul_SkAlphaType);
+	auto accumulation = SkSurface::MakeRaster(info);
+	if (accumulation == nullptr) {
+		throw RenderCreateFailure("raster surface");
+	}
+
+	auto render = std::unique_ptr<Render>(
+		new Render(std::move(RenderShader), std::move(accumulation), RenderCamera, SamplePerPass));
+
+	// The adaptive sampling blends the passes into the pixels on the CPU, which are read as float
+	render->_adaptive = AdaptiveSampling::Make(info.width(), info.height(), RenderCamera.AdaptiveThreshold,
+											   render->_samplePerPass, render->_sampleTarget);
+	if (render->_adaptive != nullptr) {
+		if (ColorType != kRGBA_F32_SkColorType) {
+			throw RenderCreateFailure("adaptive sampling on a non-F32 surface");
+		}
+
+		render->_passSurface = SkSurface::MakeRaster(info);
+		if (render->_passSurface == nullptr) {
+			throw RenderCreateFailure("pass surface");
+		}
+	}
+
+	return render;
+}
+std::unique_ptr<Render> Render::MakeTiledRaster(std::unique_ptr<Shader> RenderShader, const Camera &RenderCamera,
+												int SamplePerPass, int TileSize, int ThreadCount,
+												SkColorType ColorType) {
+	auto render = MakeRaster(std::move(RenderShader), RenderCamera, SamplePerPass, ColorType);
+
+	// The main thread only waits for the tiles, so it is not borrowed by the pool
+	render->_executor = SkExecutor::MakeFIFOThreadPool(std::max(ThreadCount, 0), false);
+	render->_tileSize = std::max(TileSize, 1);
+
+	return render;
+}
+Render::Render(std::unique_ptr<Shader> RenderShader, sk_sp<SkSurface> Accumulation, const Camera &RenderCamera,
+			   int SamplePerPass)
+	: _shader(std::move(RenderShader)), _accumulation(std::move(Accumulation)), _tileSize(0),
+	  _samplePerPass(std::max(SamplePerPass, 1)), _sampleTarget(static_cast<int>(RenderCamera.SPP)), _pass(0),
+	  _random(std::random_device{}()), _sampler(static_cast<uint32_t>(_random())),
+	  _samplerKind(static_cast<int>(RenderCamera.Sampler)), _depth(static_cast<int>(RenderCamera.Depth)) {
+	_shader->BindUniform("u_SPP", _samplePerPass);
+
+	Reset();
+}
+void Render::Reset() {
+	_accumulation->getCanvas()->clear(SK_ColorTRANSPARENT);
+	_pass = 0;
+
+	if (_adaptive != nullptr) {
+		_adaptive->Reset();
+	}
+}
+bool Render::Progress() {
+	if (Converged()) {
+		return false;
+	}
+
+	// Reseed every pass, the seed is a real uniform so the shader will not be compiled again. It is an
+	// integer exact in a float, which is hashed into the random numbers of the shader
+	std::uniform_int_distribution<int> seed(0, (1 << 20) - 1);
+	_shader->SetUniform("u_seed", static_cast<float>(seed(_random)));
+
+	// The sample points go on along the sequence through the passes, they are packed uniforms of the
+	// same size in every pass, so binding them again does not compile the shader
+	_sampler.Generate(_samplerKind, Sample(), _samplePerPass, _depth);
+	_shader->BindUniformArray("u_sample", _sampler.Uniforms(), ShaderUniformMode::Packed);
+
+	if (_adaptive != nullptr) {
+		AdaptivePass();
+	} else {
+		// Running average: accumulation = pass * 1 / (n + 1) + accumulation * n / (n + 1)
+		SkPaint paint;
+		paint.setShader(_shader->MakeShader());
+		paint.setBlendMode(SkBlendMode::kSrcOver);
+		paint.setAlphaf(1.f / static_cast<float>(_pass + 1));
+		if (_executor != nullptr) {
+			DrawTiles(paint, _accumulation.get());
+		} else {
+			_accumulation->getCanvas()->drawPaint(paint);
+		}
+	}
+
+	++_pass;
+
+	return true;
+}
+void Render::AdaptivePass() {
+	// The stopped pixels are masked out by the statistics before the pass, the shader returns at once
+	// on them
+	_shader->BindChild("u_converged",
+					   _adaptive->Snapshot()->makeShader(SkTileMode::kClamp, SkTileMode::kClamp,
+														 SkSamplingOptions(SkFilterMode::kNearest)));
+
+	// The pass is drawn as it is, then blended into each pixel by the count of the passes of the pixel
+	SkPaint paint;
+	paint.setShader(_shader->MakeShader());
+	paint.setBlendMode(SkBlendMode::kSrc);
+	if (_executor != nullptr) {
+		DrawTiles(paint, _passSurface.get());
+	} else {
+		_passSurface->getCanvas()->drawPaint(paint);
+	}
+
+	_accumulation->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+	_adaptive->Prepare();
+
+	SkPixmap pixels;
+	SkPixmap pass;
+	if (!_accumulation->peekPixels(&pixels) || !_passSurface->peekPixels(&pass)) {
+		throw RenderCreateFailure("adaptive pass pixels");
+	}
+
+	for (int y = 0; y < pixels.height(); ++y) {
+		auto row	 = static_cast<float *>(pixels.writable_addr(0, y));
+		auto passRow = static_cast<const float *>(pass.addr(0, y));
+		for (int x = 0; x < pixels.width(); ++x) {
+			if (_adaptive->Active(x, y)) {
+				auto color = passRow + 4 * x;
+				_adaptive->Accumulate(x, y, row + 4 * x, color[0], color[1], color[2]);
+			}
+		}
+	}
+	_adaptive->Finish();
+}
+void Render::DrawTiles(const SkPaint &Paint, SkSurface *Target) {
+	// The tiles write the pixels directly, detach the snapshots taken before from the pixels first
+	Target->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+
+	SkPixmap pixels;
+	if (!Target->peekPixels(&pixels)) {
+		throw RenderCreateFailure("tile surface");
+	}
+
+	int columns = (pixels.width() + _tileSize - 1) / _tileSize;
+	int rows	= (pixels.height() + _tileSize - 1) / _tileSize;
+
+	std::latch done(columns * rows);
+	for (int row = 0; row < rows; ++row) {
+		for (int column = 0; column < columns; ++column) {
+			_executor->add([&, column, row]() {
+				auto	 region = SkIRect::MakeXYWH(column * _tileSize, row * _tileSize, _tileSize, _tileSize);
+				SkPixmap tile;
+				if (pixels.extractSubset(&tile, region)) {
+					// The tiles cover disjoint regions of the accumulation pixels, nothing to stitch
+					// after drawing. The canvas is translated so the shader still gets the coordinate
+					// of the whole image
+					auto surface = SkSurface::MakeRasterDirect(tile);
+					if (surface != nullptr) {
+						surface->getCanvas()->translate(static_cast<float>(-region.fLeft),
+														static_cast<float>(-region.fTop));
+						surface->getCanvas()->drawPaint(Paint);
+					}
+				}
+
+				done.count_down();
+			});
+		}
+	}
+	done.wait();
+}
+void Render::Present(SkCanvas *Canvas) {
+	Canvas->drawImage(Snapshot(), 0, 0);
+}
+sk_sp<SkImage> Render::Snapshot() {
+	return _accumulation->makeImageSnapshot();
+}
+void Render::Converge() {
+	while (Progress()) {
+	}
+}
+void Render::Save(const std::string &Path) {
+	SaveSurface(_accumulation.get(), Path);
+}
+void Render::SaveSurface(SkSurface *Surface, const std::string &Path) {
+	// PNG can not store float color, convert the accumulated image into 8-bit sRGB first
+	SkBitmap bitmap;
+	bitmap.allocPixels(SkImageInfo::Make(Surface->width(), Surface->height(), kRGBA_8888_SkColorType,
+										 kUnpremul_SkAlphaType, SkColorSpace::MakeSRGB()));
+	if (!Surface->readPixels(bitmap.pixmap(), 0, 0)) {
+		throw RenderSaveFailure(Path.c_str());
+	}
+
+	SkFILEWStream stream(Path.c_str());
+	if (!stream.isValid() || !SkEncodeImage(&stream, bitmap.pixmap(), SkEncodedImageFormat::kPNG, 100)) {
+		throw RenderSaveFailure(Path.c_str());
+	}
+}
+} // namespace Vedo
\ No newline at end of file
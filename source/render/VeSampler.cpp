@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeSampler.cpp
+ * \brief The low discrepancy sampler of the Vedo renderer
+ */
+
+#include <include/math/VeRandom.h>
+#include <include/render/VeSampler.h>
+
+namespace Vedo {
+namespace {
+uint32_t ReverseBits(uint32_t Value) {
+	Value = ((Value >> 1u) & 0x55555555u) | ((Value & 0x55555555u) << 1u);
+	Value = ((Value >> 2u) & 0x33333333u) | ((Value & 0x33333333u) << 2u);
+	Value = ((Value >> 4u) & 0x0F0F0F0Fu) | ((Value & 0x0F0F0F0Fu) << 4u);
+	Value = ((Value >> 8u) & 0x00FF00FFu) | ((Value & 0x00FF00FFu) << 8u);
+
+	return (Value >> 16u) | (Value << 16u);
+}
+/**
+ * The Owen scrambling of the bits by the hash of Laine and Karras, each bit is flipped by the hash
+ * of the bits above it. The multiplication carries the lower bits into the higher ones, so the
+ * bits are reversed around it
+ */
+uint32_t NestedUniformScramble(uint32_t Value, uint32_t Seed) {
+	Value = ReverseBits(Value);
+	Value += Seed;
+	Value ^= Value * 0x6C50B47Cu;
+	Value ^= Value * 0xB82F1E52u;
+	Value ^= Value * 0xC7AFE638u;
+	Value ^= Value * 0x8D22F6E6u;
+
+	return ReverseBits(Value);
+}
+uint32_t HashCombine(uint32_t Seed, uint32_t Value) {
+	return Seed ^ (Value + 0x9E3779B9u + (Seed << 6u) + (Seed >> 2u));
+}
+} // namespace
+
+Sampler::Sampler(uint32_t Seed) : _seed(Seed), _stride(1) {
+}
+void Sampler::Generate(int Kind, int First, int Count, int Depth) {
+	_stride = std::max(Depth, 0) + 1;
+	_points.assign(static_cast<size_t>(std::max(Count, 1) * _stride), SamplePoint());
+	if (Kind != SobolSampler) {
+		return;
+	}
+
+	// Every pair of dimensions takes the sequence of its own seed, the camera takes the pairs 0 and 1,
+	// the bounce N takes the pairs 2 + 2N and 3 + 2N
+	for (int sample = 0; sample < Count; ++sample) {
+		auto index = static_cast<uint32_t>(First + sample);
+		for (int dimension = 0; dimension < _stride; ++dimension) {
+			auto pair  = static_cast<uint32_t>(dimension * 2);
+			auto first = Sobol(index, PCGHash(HashCombine(_seed, pair)));
+			auto other = Sobol(index, PCGHash(HashCombine(_seed, pair + 1)));
+
+			_points[sample * _stride + dimension].Value = {first.x, first.y, other.x, other.y};
+		}
+	}
+}
+Vec2 Sampler::Sobol(uint32_t Index, uint32_t Seed) {
+	// The shuffling is the Owen scrambling of the index, it keeps the aligned blocks of 2^N indices,
+	// which are the stratified sets of the sequence
+	Index = NestedUniformScramble(Index, Seed);
+
+	// The first dimension is the van der Corput sequence, the direction numbers of the second one are
+	// the columns of the Pascal matrix modulo 2
+	uint32_t x = ReverseBits(Index);
+	uint32_t y = 0;
+	for (uint32_t direction = 1u << 31u; Index != 0; Index >>= 1u, direction ^= direction >> 1u) {
+		if ((Index & 1u) != 0) {
+			y ^= direction;
+		}
+	}
+
+	x = NestedUniformScramble(x, HashCombine(Seed, 0));
+	y = NestedUniformScramble(y, HashCombine(Seed, 1));
+
+	// The top 24 bits are exact in a float
+	return {static_cast<float>(x >> 8u) * (1.f / 16777216.f), static_cast<float>(y >> 8u) * (1.f / 16777216.f)};
+}
+std::vector<SamplePoint *> Sampler::Uniforms() {
+	std::vector<SamplePoint *> uniforms;
+	uniforms.reserve(_points.size());
+	for (auto &point : _points) {
+		uniforms.push_back(&point);
+	}
+
+	return uniforms;
+}
+} // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeSceneFile.cpp
+ * \brief The binary scene file of Vedo, which is mapped into the memory when it is opened
+ */
+
+#include <include/render/VeSceneFile.h>
+
+#include <fstream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vedo {
+namespace {
+constexpr char Magic[8] = {'V', 'E', 'D', 'O', 'S', 'C', 'N', '\0'};
+/**
+ * Written as it is, a file of another byte order reads it reversed
+ */
+constexpr uint32_t ByteOrder = 0x01020304;
+/**
+ * The alignment of the sections, every record is read in place from the mapped memory
+ */
+constexpr size_t SectionAlignment = 64;
+
+enum Section : int {
+	CameraSection,
+	MaterialSection,
+	ObjectSection,
+	MeshSection,
+	VertexXSection,
+	VertexYSection,
+	VertexZSection,
+	IndexSection,
+	NodeSection,
+	SectionCount
+};
+
+struct SectionRecord {
+	uint64_t Offset;
+	uint64_t Count;
+};
+struct HeaderRecord {
+	char		  Magic[8];
+	uint32_t	  Version;
+	uint32_t	  ByteOrder;
+	SectionRecord Sections[SectionCount];
+};
+struct CameraRecord {
+	float Ratio;
+	float Width;
+	float SPP;
+	float Depth;
+	float LookFrom[3];
+	float LookAt[3];
+	float VUP[3];
+	float FOV;
+	float FocusDistance;
+	float DeFocusAngle;
+	float Sampler;
+	float RouletteDepth;
+	float AdaptiveThreshold;
+};
+struct MaterialRecord {
+	int32_t Kind;
+	float	Albedo[3];
+	float	Fuzz;
+	float	IndexRefraction;
+};
+struct ObjectRecord {
+	/**
+	 * The index of the material in the material section
+	 */
+	int32_t Material;
+	int32_t Shape;
+	float	Center[3];
+	float	Radius;
+	/**
+	 * The index of the mesh in the mesh section, -1 for none
+	 */
+	int32_t Mesh;
+};
+struct MeshRecord {
+	uint64_t FirstVertex;
+	uint64_t VertexCount;
+	uint64_t FirstIndex;
+	uint64_t IndexCount;
+};
+struct NodeRecord {
+	float	BoundMin[3];
+	float	BoundMax[3];
+	int32_t Escape;
+	int32_t Object;
+	int32_t Triangle;
+};
+
+/**
+ * Get the size of the records of each section
+ */
+constexpr size_t RecordSize[SectionCount] = {sizeof(CameraRecord), sizeof(MaterialRecord), sizeof(ObjectRecord),
+											 sizeof(MeshRecord),   sizeof(float),			sizeof(float),
+											 sizeof(float),		   sizeof(uint32_t),		sizeof(NodeRecord)};
+
+void CopyVector(float *Target, const Vec3 &Vector) {
+	Target[0] = Vector.x;
+	Target[1] = Vector.y;
+	Target[2] = Vector.z;
+}
+Vec3 ReadVector(const float *Source) {
+	return {Source[0], Source[1], Source[2]};
+}
+} // namespace
+
+void SceneFile::Save(const std::string &Path, const Camera &SceneCamera, const MaterialTable &Materials,
+					 const std::vector<Object *> &Objects, const BVH &Tree) {
+	if (!Tree.InstanceNodes().empty()) {
+		throw SceneFileSaveFailure(Path.c_str());
+	}
+
+	std::vector<MaterialRecord> materials;
+	materials.reserve(Materials.Size());
+	for (auto &material : Materials.Materials()) {
+		MaterialRecord record{material.Kind, {}, material.Fuzz, material.IndexRefraction};
+		CopyVector(record.Albedo, material.Albedo);
+		materials.push_back(record);
+	}
+
+	// The meshes shared by the objects are stored once, in the order they first appear
+	std::vector<const Mesh *>					 meshes;
+	std::unordered_map<const Mesh *, int32_t> meshIndex;
+	std::vector<ObjectRecord>					 objects;
+	objects.reserve(Objects.size());
+	for (auto &object : Objects) {
+		int32_t mesh = -1;
+		if (object->Shape == MeshGeometry && object->Geometry != nullptr) {
+			auto [iterator, inserted] = meshIndex.emplace(object->Geometry, static_cast<int32_t>(meshes.size()));
+			if (inserted) {
+				meshes.push_back(object->Geometry);
+			}
+			mesh = iterator->second;
+		}
+
+		if (object->Material < 0 || object->Material >= Materials.Size() ||
+			(object->Shape == MeshGeometry && object->Geometry == nullptr)) {
+			throw SceneFileSaveFailure(Path.c_str());
+		}
+
+		ObjectRecord record{object->Material, object->Shape, {}, object->Radius, mesh};
+		CopyVector(record.Center, object->Center);
+		objects.push_back(record);
+	}
+
+	std::vector<MeshRecord> meshRecords;
+	uint64_t				vertexCount = 0;
+	uint64_t				indexCount	= 0;
+	for (auto &mesh : meshes) {
+		meshRecords.push_back({vertexCount, mesh->VertexCount(), indexCount, mesh->Indices().size()});
+		vertexCount += mesh->VertexCount();
+		indexCount += mesh->Indices().size();
+	}
+
+	std::vector<NodeRecord> nodes;
+	nodes.reserve(Tree.Nodes().size());
+	for (auto &node : Tree.Nodes()) {
+		NodeRecord record{{}, {}, node.Escape, node.Object, node.Triangle};
+		CopyVector(record.BoundMin, node.BoundMin);
+		CopyVector(record.BoundMax, node.BoundMax);
+		nodes.push_back(record);
+	}
+
+	CameraRecord camera{SceneCamera.Ratio, SceneCamera.Width, SceneCamera.SPP, SceneCamera.Depth, {}, {}, {},
+						SceneCamera.FOV, SceneCamera.FocusDistance, SceneCamera.DeFocusAngle, SceneCamera.Sampler,
+						SceneCamera.RouletteDepth, SceneCamera.AdaptiveThreshold};
+	CopyVector(camera.LookFrom, SceneCamera.LookFrom);
+	CopyVector(camera.LookAt, SceneCamera.LookAt);
+	CopyVector(camera.VUP, SceneCamera.VUP);
+
+	// Lay out the sections one after another behind the header
+	HeaderRecord header{};
+	std::copy(std::begin(Magic), std::end(Magic), header.Magic);
+	header.Version	 = Version;
+	header.ByteOrder = ByteOrder;
+
+	uint64_t counts[SectionCount] = {1,			  materials.size(), objects.size(), meshRecords.size(), vertexCount,
+									 vertexCount, vertexCount,		indexCount,		nodes.size()};
+	uint64_t offset				  = sizeof(HeaderRecord);
+	for (int section = 0; section < SectionCount; ++section) {
+		offset					  = (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+		header.Sections[section] = {offset, counts[section]};
+		offset += counts[section] * RecordSize[section];
+	}
+
+	std::ofstream file(Path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw SceneFileSaveFailure(Path.c_str());
+	}
+
+	auto write = [&](int Section, const void *Data, size_t Size) {
+		auto position = static_cast<uint64_t>(file.tellp());
+		std::vector<char> padding(header.Sections[Section].Offset - position, 0);
+		file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+		file.write(static_cast<const char *>(Data), static_cast<std::streamsize>(Size));
+	};
+
+	file.write(reinterpret_cast<const char *>(&header), sizeof(HeaderRecord));
+	write(CameraSection, &camera, sizeof(CameraRecord));
+	write(MaterialSection, materials.data(), materials.size() * sizeof(MaterialRecord));
+	write(ObjectSection, objects.data(), objects.size() * sizeof(ObjectRecord));
+	write(MeshSection, meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+	write(VertexXSection, nullptr, 0);
+	for (auto &mesh : meshes) {
+		file.write(reinterpret_cast<const char *>(mesh->X().data()), static_cast<std::streamsize>(mesh->X().size_bytes()));
+	}
+	write(VertexYSection, nullptr, 0);
+	for (auto &mesh : meshes) {
+		file.write(reinterpret_cast<const char *>(mesh->Y().data()), static_cast<std::streamsize>(mesh->Y().size_bytes()));
+	}
+	write(VertexZSection, nullptr, 0);
+	for (auto &mesh : meshes) {
+		file.write(reinterpret_cast<const char *>(mesh->Z().data()), static_cast<std::streamsize>(mesh->Z().size_bytes()));
+	}
+	write(IndexSection, nullptr, 0);
+	for (auto &mesh : meshes) {
+		file.write(reinterpret_cast<const char *>(mesh->Indices().data()),
+				   static_cast<std::streamsize>(mesh->Indices().size_bytes()));
+	}
+	write(NodeSection, nodes.data(), nodes.size() * sizeof(NodeRecord));
+
+	if (!file.good()) {
+		throw SceneFileSaveFailure(Path.c_str());
+	}
+}
+template <class RecordType> std::span<const RecordType> SceneFile::Records(int Section) const {
+	HeaderRecord header{};
+	memcpy(&header, _data, sizeof(HeaderRecord));
+
+	auto &record = header.Sections[Section];
+	return {reinterpret_cast<const RecordType *>(_data + record.Offset), static_cast<size_t>(record.Count)};
+}
+std::unique_ptr<SceneFile> SceneFile::Open(const std::string &Path) {
+	auto scene	 = std::unique_ptr<SceneFile>(new SceneFile());
+	scene->_path = Path;
+
+#ifdef _WIN32
+	auto file = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw SceneFileOpenFailure(Path.c_str());
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	scene->_size = static_cast<size_t>(size.QuadPart);
+
+	// The view keeps the mapping alive, so the handles are closed right away
+	auto mapping = scene->_size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	if (mapping != nullptr) {
+		scene->_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	auto file = open(Path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw SceneFileOpenFailure(Path.c_str());
+	}
+
+	struct stat status {};
+	fstat(file, &status);
+	scene->_size = static_cast<size_t>(status.st_size);
+
+	// The mapping stays valid after the descriptor is closed
+	if (scene->_size > 0) {
+		auto data	 = mmap(nullptr, scene->_size, PROT_READ, MAP_PRIVATE, file, 0);
+		scene->_data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t *>(data);
+	}
+	close(file);
+#endif
+	if (scene->_data == nullptr) {
+		throw SceneFileOpenFailure(Path.c_str());
+	}
+
+	// The header, the tables and the indices are checked, the vertices are used in place
+	HeaderRecord header{};
+	if (scene->_size < sizeof(HeaderRecord)) {
+		throw SceneFileInvalidFormat(Path.c_str());
+	}
+	memcpy(&header, scene->_data, sizeof(HeaderRecord));
+	if (!std::equal(std::begin(Magic), std::end(Magic), header.Magic) || header.Version != Version ||
+		header.ByteOrder != ByteOrder) {
+		throw SceneFileInvalidFormat(Path.c_str());
+	}
+	for (int section = 0; section < SectionCount; ++section) {
+		auto &record = header.Sections[section];
+		if (record.Offset % SectionAlignment != 0 || record.Offset > scene->_size ||
+			record.Count > (scene->_size - record.Offset) / RecordSize[section]) {
+			throw SceneFileInvalidFormat(Path.c_str());
+		}
+	}
+
+	auto cameras   = scene->Records<CameraRecord>(CameraSection);
+	auto materials = scene->Records<MaterialRecord>(MaterialSection);
+	auto objects   = scene->Records<ObjectRecord>(ObjectSection);
+	auto meshes	   = scene->Records<MeshRecord>(MeshSection);
+	auto x		   = scene->Records<float>(VertexXSection);
+	auto y		   = scene->Records<float>(VertexYSection);
+	auto z		   = scene->Records<float>(VertexZSection);
+	auto indices   = scene->Records<uint32_t>(IndexSection);
+	if (cameras.size() != 1 || y.size() != x.size() || z.size() != x.size()) {
+		throw SceneFileInvalidFormat(Path.c_str());
+	}
+
+	auto &camera					 = cameras.front();
+	scene->_camera.Ratio			 = camera.Ratio;
+	scene->_camera.Width			 = camera.Width;
+	scene->_camera.SPP				 = camera.SPP;
+	scene->_camera.Depth			 = camera.Depth;
+	scene->_camera.LookFrom			 = ReadVector(camera.LookFrom);
+	scene->_camera.LookAt			 = ReadVector(camera.LookAt);
+	scene->_camera.VUP				 = ReadVector(camera.VUP);
+	scene->_camera.FOV				 = camera.FOV;
+	scene->_camera.FocusDistance	 = camera.FocusDistance;
+	scene->_camera.DeFocusAngle		 = camera.DeFocusAngle;
+	scene->_camera.Sampler			 = camera.Sampler;
+	scene->_camera.RouletteDepth	 = camera.RouletteDepth;
+	scene->_camera.AdaptiveThreshold = camera.AdaptiveThreshold;
+	scene->_camera.Init();
+
+	// The equal materials of a file written by hand are merged, the objects are mapped to the merged ones
+	std::vector<int> materialIndex;
+	materialIndex.reserve(materials.size());
+	for (auto &record : materials) {
+		Material material;
+		material.Kind			 = record.Kind;
+		material.Albedo			 = ReadVector(record.Albedo);
+		material.Fuzz			 = record.Fuzz;
+		material.IndexRefraction = record.IndexRefraction;
+		materialIndex.push_back(scene->_materials.Add(material));
+	}
+
+	scene->_meshes.reserve(meshes.size());
+	for (auto &mesh : meshes) {
+		if (mesh.FirstVertex > x.size() || mesh.VertexCount > x.size() - mesh.FirstVertex ||
+			mesh.FirstIndex > indices.size() || mesh.IndexCount > indices.size() - mesh.FirstIndex) {
+			throw SceneFileInvalidFormat(Path.c_str());
+		}
+		try {
+			scene->_meshes.push_back(Mesh::MakeView(x.subspan(mesh.FirstVertex, mesh.VertexCount),
+													y.subspan(mesh.FirstVertex, mesh.VertexCount),
+													z.subspan(mesh.FirstVertex, mesh.VertexCount),
+													indices.subspan(mesh.FirstIndex, mesh.IndexCount)));
+		} catch (const MeshInvalidIndex &) {
+			throw SceneFileInvalidFormat(Path.c_str());
+		} catch (const MeshInvalidIndexCount &) {
+			throw SceneFileInvalidFormat(Path.c_str());
+		}
+	}
+
+	scene->_objects.resize(objects.size());
+	for (size_t index = 0; index < objects.size(); ++index) {
+		auto &record = objects[index];
+		auto &object = scene->_objects[index];
+		auto validShape = record.Shape == SphereGeometry || (record.Shape == MeshGeometry && record.Mesh >= 0);
+		if (!validShape || record.Mesh < -1 || record.Mesh >= static_cast<int32_t>(meshes.size()) ||
+			record.Material < 0 || record.Material >= static_cast<int32_t>(materials.size())) {
+			throw SceneFileInvalidFormat(Path.c_str());
+		}
+
+		object.Material = materialIndex[record.Material];
+		object.Shape	= record.Shape;
+		object.Center	= ReadVector(record.Center);
+		object.Radius	= record.Radius;
+		object.Geometry = record.Mesh >= 0 ? scene->_meshes[record.Mesh].get() : nullptr;
+	}
+
+	return scene;
+}
+SceneFile::~SceneFile() {
+	if (_data == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+#else
+	munmap(const_cast<uint8_t *>(_data), _size);
+#endif
+}
+std::vector<Object *> SceneFile::Objects() {
+	std::vector<Object *> objects;
+	objects.reserve(_objects.size());
+	for (auto &object : _objects) {
+		objects.push_back(&object);
+	}
+
+	return objects;
+}
+std::unique_ptr<BVH> SceneFile::MakeBVH() const {
+	auto records	 = Records<NodeRecord>(NodeSection);
+	auto count		 = static_cast<int32_t>(records.size());
+	auto objectCount = static_cast<int32_t>(_objects.size());
+
+	// The renders index the objects and the triangles by the nodes, so the references are checked
+	std::vector<int64_t> triangleBase(_objects.size() + 1, 0);
+	for (size_t index = 0; index < _objects.size(); ++index) {
+		triangleBase[index + 1] = triangleBase[index] + static_cast<int64_t>(BVH::TriangleCount(_objects[index]));
+	}
+
+	std::vector<BVHNode> nodes(records.size());
+	for (int32_t index = 0; index < count; ++index) {
+		auto &record = records[index];
+		auto &node	 = nodes[index];
+
+		auto validObject   = record.Object < objectCount;
+		auto validTriangle = record.Triangle < 0 || (record.Object >= 0 && validObject &&
+													 record.Triangle >= triangleBase[record.Object] &&
+													 record.Triangle < triangleBase[record.Object + 1]);
+		if (record.Escape <= index || record.Escape > count || !validObject || !validTriangle) {
+			throw SceneFileInvalidFormat(_path.c_str());
+		}
+
+		node.BoundMin = ReadVector(record.BoundMin);
+		node.BoundMax = ReadVector(record.BoundMax);
+		node.Escape	  = record.Escape;
+		node.Object	  = record.Object;
+		node.Triangle = record.Triangle;
+		node.Instance = -1;
+
+		// The material of the leaf is taken from its object, the objects refer to the merged materials
+		node.Material	 = record.Object >= 0 ? _objects[record.Object].Material : -1;
+		node.Root		 = -1;
+		node.Translation = {};
+		node.InverseX	 = {};
+		node.InverseY	 = {};
+		node.InverseZ	 = {};
+	}
+
+	return BVH::MakeFromNodes(std::move(nodes));
+}
+} // namespace Vedo
\ No newline at end of file
@@ -26,173 +26,541 @@
  */
 
 #include <include/shader/VeShader.h>
+#include <include/shader/VeShaderCache.h>
+
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+
+namespace {
+/**
+ * The characters which may start a comment, a string or a rewriting site
+ */
+constexpr auto SpecialCharacter = [] {
+	std::array<bool, 256> table{};
+	for (unsigned char character : std::string_view("/\"'$@")) {
+		table[character] = true;
+	}
+
+	return table;
+}();
+
+bool IsIdentifierStart(char Character) {
+	return std::isalpha(static_cast<unsigned char>(Character)) || Character == '_' || Character == '$';
+}
+bool IsIdentifier(char Character) {
+	return std::isalnum(static_cast<unsigned char>(Character)) || Character == '_' || Character == '$';
+}
+/**
+ * Skip the comment or the literal string at the cursor
+ * @return The position after the comment or the string, or the cursor itself when there is none
+ */
+const char *SkipCommentOrString(const char *Cursor, const char *End) {
+	if (Cursor + 1 < End && Cursor[0] == '/' && Cursor[1] == '/') {
+		auto line = std::find(Cursor, End, '\n');
+		return line == End ? End : line + 1;
+	}
+	if (Cursor + 1 < End && Cursor[0] == '/' && Cursor[1] == '*') {
+		auto close = std::search(Cursor + 2, End, "*/", "*/" + 2);
+		return close == End ? End : close + 2;
+	}
+	if (Cursor[0] == '"' || Cursor[0] == '\'') {
+		const char quote = *Cursor++;
+		while (Cursor < End && *Cursor != quote && *Cursor != '\n') {
+			Cursor += (*Cursor == '\\' && Cursor + 1 < End) ? 2 : 1;
+		}
+		return Cursor < End ? Cursor + 1 : End;
+	}
+
+	return Cursor;
+}
+/**
+ * Skip the white spaces and the comments at the cursor
+ * @return The position of the next token
+ */
+const char *SkipSpace(const char *Cursor, const char *End) {
+	while (Cursor < End) {
+		if (std::isspace(static_cast<unsigned char>(*Cursor))) {
+			++Cursor;
+		} else if (*Cursor == '/' && SkipCommentOrString(Cursor, End) != Cursor) {
+			Cursor = SkipCommentOrString(Cursor, End);
+		} else {
+			break;
+		}
+	}
+
+	return Cursor;
+}
+/**
+ * Read an identifier at the cursor, the white spaces before it will be skipped
+ * @return The identifier, empty when there is no identifier at the cursor
+ */
+std::string_view ReadIdentifier(const char *&Cursor, const char *End) {
+	Cursor			  = SkipSpace(Cursor, End);
+	const char *begin = Cursor;
+	if (Cursor < End && IsIdentifierStart(*Cursor)) {
+		while (Cursor < End && IsIdentifier(*Cursor)) {
+			++Cursor;
+		}
+	}
+
+	return {begin, static_cast<size_t>(Cursor - begin)};
+}
+/**
+ * Read an expected punctuation at the cursor, the white spaces before it will be skipped
+ * @return Whether the punctuation is read
+ */
+bool ReadPunctuation(const char *&Cursor, const char *End, char Punctuation) {
+	Cursor = SkipSpace(Cursor, End);
+	if (Cursor < End && *Cursor == Punctuation) {
+		++Cursor;
+
+		return true;
+	}
+
+	return false;
+}
+} // namespace
 
 namespace Vedo {
 Shader::Shader(const char *ShaderCode) : _code(ShaderCode) {
 }
 std::string Shader::MakeCode() {
-	auto linkedCode = Preprocess();
+	Build();
 
-	auto [instance, error] = std::move(SkRuntimeEffect::MakeForShader(SkString(linkedCode.c_str())));
-	if (!error.isEmpty()) {
-		throw ShaderCreateFailure(error.c_str());
+	return _linkedCode;
+}
+sk_sp<SkRuntimeEffect> Shader::MakeEffect() {
+	Build();
+
+	return _effect;
+}
+sk_sp<SkShader> Shader::MakeShader() {
+	Build();
+
+	// The children are passed in the order of the declaration
+	std::vector<SkRuntimeEffect::ChildPtr> children(_effect->children().size(),
+													SkRuntimeEffect::ChildPtr(SkShaders::Empty()));
+	for (auto &[name, shader] : _children) {
+		auto child = _effect->findChild(name.c_str());
+		if (child != nullptr) {
+			children[child->index] = SkRuntimeEffect::ChildPtr(shader);
+		}
 	}
 
-	return linkedCode;
+	return _effect->makeShader(MakeUniformData(), {children.data(), children.size()});
 }
-std::string Shader::Preprocess() {
-	stb_lexer	lexer;
-	const char *code = _code.c_str();
-	stb_c_lexer_init(&lexer, code, code + strlen(code), (char *)malloc(0x10000), 0x10000);
+void Shader::BindStructures(const std::string &Name, std::vector<IShaderStructureUniform *> Structures,
+							ShaderUniformMode Mode, IShaderStructureUniform *Layout) {
+	UniformArray array{std::move(Structures), Mode, {}, {}, 0, 0, {}};
+	if (Mode == ShaderUniformMode::Packed) {
+		// The empty array still reserves one element of the layout, SKSL can not declare an array of
+		// zero length
+		auto structure = array.Structures.empty() ? Layout : array.Structures.front();
+		if (structure == nullptr) {
+			throw ShaderEmptyUniform(Name.c_str());
+		}
+
+		array.Capacity = std::bit_ceil(std::max<size_t>(array.Structures.size(), 1));
+		array.Names	   = structure->PropertyList();
+		array.Types	   = structure->PropertyType();
+		if (array.Names.size() != array.Types.size()) {
+			throw ShaderUnpackableUniform(structure->Type().c_str());
+		}
+		for (auto &type : array.Types) {
+			array.Stride += ShaderPropertySize(type);
+		}
+	}
 
-	std::string result = "void init_vedo();";
+	// The translated code of a packed array only depends on its capacity and layout, the layout is
+	// the names and the types of the fields, two layouts of the same stride are not interchangeable
+	auto previous = _uniformReplacement.find(Name);
+	if (previous == _uniformReplacement.end() || Mode == ShaderUniformMode::Inline ||
+		previous->second.Mode != Mode || previous->second.Stride != array.Stride ||
+		previous->second.Capacity != array.Capacity || previous->second.Names != array.Names ||
+		previous->second.Types != array.Types) {
+		_dirty = true;
+	} else {
+		array.Code = std::move(previous->second.Code);
+	}
 
-	while (stb_c_lexer_get_token(&lexer)) {
-		if (lexer.token == '@' && stb_c_lexer_get_token(&lexer) && strcmp(lexer.string, "uniform") == 0) {
-			// Skip white space
-			stb_c_lexer_get_token(&lexer);
-			stb_c_lexer_get_token(&lexer);
-			stb_c_lexer_get_token(&lexer);
-			stb_c_lexer_get_token(&lexer);
-			std::string type = lexer.string;
+	_uniformReplacement[Name] = std::move(array);
+}
+void Shader::Build() {
+	// The values of inline arrays are baked into the code, the code must be translated again to
+	// catch up with the values of the structures
+	auto inlineArray = std::ranges::any_of(_uniformReplacement, [](const auto &Uniform) {
+		return Uniform.second.Mode == ShaderUniformMode::Inline;
+	});
+	if (!_dirty && !inlineArray && _effect) {
+		return;
+	}
 
-			stb_c_lexer_get_token(&lexer);
-			if (_uniformReplacement.contains(lexer.string)) {
-				auto id		   = lexer.string;
-				auto structure = _uniformReplacement[lexer.string];
+	_dirty = false;
+	if (inlineArray) {
+		Preprocess(_linkedCode);
+		// The effect is kept by the cache, the next request of the same code will not be compiled again
+		_effect		= ShaderCache::Instance().MakeEffect(_linkedCode);
 
-				// Add size measure
-				result.append(std::format("\nconst int l_{} = {};\n", id, structure.size()));
-				result.append(std::format("\nconst float lf_{} = {};\n", id, structure.size()));
+		return;
+	}
 
-				// Define variable
-				result.append(std::format("\n{} {}[{}];\n", type, id, structure.size()));
+	if (!_parsed) {
+		Parse();
+	}
 
-				std::string initBodyCode;
-				for (int count = 0; count < structure.size(); ++count) {
-					auto property = structure[count]->PropertyValue();
-					for (auto &instance : property) {
-						initBodyCode.append(std::format("{}[{}].{} = {};\n", id, count, instance.first, instance.second));
-					}
-				}
+	// Switching back to a capacity bucket used before will neither translate nor compile the code
+	auto key	 = VariantKey();
+	auto variant = _variants.find(key);
+	if (variant == _variants.end()) {
+		std::string code;
+		Preprocess(code);
+		auto effect = ShaderCache::Instance().MakeEffect(code);
 
-				result.append(std::format("void func_init_{}() {{\n {} }}\n", id, initBodyCode));
-			} else {
-				throw ShaderInvalidUniform(lexer.string);
+		// The least recently used variant is dropped, its effect is still kept by the shader cache
+		if (_variants.size() >= MaxVariant) {
+			_variants.erase(std::ranges::min_element(_variants, {}, [](const auto &Entry) {
+				return Entry.second.LastUse;
+			}));
+		}
+		variant = _variants.emplace(key, Variant{std::move(code), std::move(effect), 0}).first;
+	}
+	variant->second.LastUse = ++_variantUse;
+
+	_linkedCode = variant->second.Code;
+	_effect		= variant->second.Effect;
+}
+std::string Shader::VariantKey() const {
+	std::string key;
+	// Only the tags in the code are a part of the key, in the order of their appearance
+	for (auto &segment : _segments) {
+		if (segment.Kind != SegmentKind::Variable) {
+			continue;
+		}
+
+		auto replacement = _linkReplacement.find(segment.Text);
+		if (replacement != _linkReplacement.end()) {
+			key.append(std::format("{}={};", segment.Text, replacement->second));
+		}
+	}
+	for (auto &[name, array] : _uniformReplacement) {
+		key.append(std::format("{}[{}x{}]{{", name, array.Capacity, array.Stride));
+		for (size_t field = 0; field < array.Names.size(); ++field) {
+			key.append(std::format("{}:{},", array.Names[field], static_cast<int>(array.Types[field])));
+		}
+		key.append("};");
+	}
+
+	return key;
+}
+sk_sp<SkData> Shader::MakeUniformData() {
+	if (_effect->uniformSize() == 0) {
+		return nullptr;
+	}
+
+	auto data = SkData::MakeUninitialized(_effect->uniformSize());
+	memset(data->writable_data(), 0, data->size());
+
+	for (auto &[name, value] : _uniformValue) {
+		auto uniform = _effect->findUniform(name.c_str());
+		if (uniform != nullptr) {
+			memcpy(static_cast<uint8_t *>(data->writable_data()) + uniform->offset, value.data(),
+				   std::min(value.size(), uniform->sizeInBytes()));
+		}
+	}
+
+	for (auto &[name, array] : _uniformReplacement) {
+		if (array.Mode != ShaderUniformMode::Packed) {
+			continue;
+		}
+
+		auto base = static_cast<uint8_t *>(data->writable_data());
+
+		auto count = _effect->findUniform(std::format("n_{}", name).c_str());
+		if (count != nullptr) {
+			*reinterpret_cast<int32_t *>(base + count->offset) = static_cast<int32_t>(array.Structures.size());
+		}
+
+		auto uniform = _effect->findUniform(std::format("vd_{}", name).c_str());
+		if (uniform == nullptr) {
+			continue;
+		}
+
+		auto block = reinterpret_cast<float *>(base + uniform->offset);
+		for (auto &structure : array.Structures) {
+			structure->PropertyData(block);
+			block += array.Stride;
+		}
+	}
+
+	return data;
+}
+void Shader::PackedUniformCode(std::string &Output, std::string_view Name, std::string_view StructureType,
+							   const UniformArray &Array) {
+	const auto length = Array.Capacity;
+
+	// Add size measure, "l_" is the capacity and "n_" is the live length
+	Output.append(std::format("\nconst int l_{} = {};\n", Name, length));
+	Output.append(std::format("\nconst float lf_{} = {};\n", Name, length));
+	Output.append(std::format("\nuniform int n_{};\n", Name));
+
+	// Define the packed block and the variable unpacked from it
+	Output.append(std::format("\nuniform float vd_{}[{}];\n", Name, length * Array.Stride));
+	Output.append(std::format("\n{} {}[{}];\n", StructureType, Name, length));
+
+	std::string initBodyCode;
+	int			offset = 0;
+	for (size_t count = 0; count < Array.Names.size(); ++count) {
+		auto slot = [&](int Index) {
+			return std::format("vd_{}[index * {} + {}]", Name, Array.Stride, offset + Index);
+		};
+
+		std::string value;
+		switch (Array.Types[count]) {
+		case ShaderPropertyType::Int:
+			value = std::format("int({})", slot(0));
+			break;
+		case ShaderPropertyType::Float:
+			value = slot(0);
+			break;
+		case ShaderPropertyType::Vec2:
+			value = std::format("vec2({}, {})", slot(0), slot(1));
+			break;
+		case ShaderPropertyType::Vec3:
+			value = std::format("vec3({}, {}, {})", slot(0), slot(1), slot(2));
+			break;
+		case ShaderPropertyType::Vec4:
+			value = std::format("vec4({}, {}, {}, {})", slot(0), slot(1), slot(2), slot(3));
+			break;
+		}
+
+		initBodyCode.append(std::format("{}[index].{} = {};\n", Name, Array.Names[count], value));
+		offset += ShaderPropertySize(Array.Types[count]);
+	}
+
+	Output.append(std::format("void func_init_{0}() {{\n for (int index = 0; index < {1}; ++index) {{\n"
+							"if (index >= n_{0}) {{ break; }}\n {2} }}\n}}\n",
+							Name, length, initBodyCode));
+}
+void Shader::InlineUniformCode(std::string &Output, std::string_view Name, std::string_view StructureType,
+							   const UniformArray &Array) {
+	auto &structure = Array.Structures;
+
+	// Add size measure
+	Output.append(std::format("\nconst int l_{} = {};\n", Name, structure.size()));
+	Output.append(std::format("\nconst float lf_{} = {};\n", Name, structure.size()));
+	Output.append(std::format("\nconst int n_{} = {};\n", Name, structure.size()));
+
+	// Define variable
+	Output.append(std::format("\n{} {}[{}];\n", StructureType, Name, structure.size()));
+
+	Output.append(std::format("void func_init_{}() {{\n", Name));
+	for (size_t count = 0; count < structure.size(); ++count) {
+		auto fields = structure[count]->Fields();
+		if (fields.empty()) {
+			auto property = structure[count]->PropertyValue();
+			for (auto &instance : property) {
+				Output.append(std::format("{}[{}].{} = {};\n", Name, count, instance.first, instance.second));
 			}
 
-			stb_c_lexer_get_token(&lexer);
-		} else if (lexer.string[0] == '$' && lexer.token == CLEX_id) {
-			if (_linkReplacement.contains(lexer.string)) {
-				result.append(_linkReplacement[lexer.string]);
-			} else {
-				throw ShaderInvalidVariable(lexer.string);
+			continue;
+		}
+
+		char index[32];
+		auto indexEnd = std::to_chars(index, index + sizeof(index), count).ptr;
+
+		// Write the literals directly, no intermediate string is made for the values
+		for (auto &field : fields) {
+			float data[4];
+			field.Read(structure[count], data);
+
+			Output.append(Name).append("[").append(index, indexEnd).append("].");
+			Output.append(field.Name).append(" = ");
+			AppendLiteral(Output, field.Type, data);
+			Output.append(";\n");
+		}
+	}
+	Output.append("}\n");
+}
+void Shader::AppendLiteral(std::string &Buffer, ShaderPropertyType Type, const float *Data) {
+	char number[32];
+	auto appendFloat = [&](float Value) {
+		auto end = std::to_chars(number, number + sizeof(number), Value).ptr;
+		Buffer.append(number, end);
+		// Make sure the literal is a float literal in SKSL
+		if (std::find_if(number, end, [](char Character) {
+				return Character == '.' || Character == 'e' || Character == 'n';
+			}) == end) {
+			Buffer.append(".0");
+		}
+	};
+
+	switch (Type) {
+	case ShaderPropertyType::Int: {
+		auto end = std::to_chars(number, number + sizeof(number), static_cast<int>(Data[0])).ptr;
+		Buffer.append(number, end);
+
+		return;
+	}
+	case ShaderPropertyType::Float: {
+		appendFloat(Data[0]);
+
+		return;
+	}
+	case ShaderPropertyType::Vec2:
+		Buffer.append("vec2(");
+		break;
+	case ShaderPropertyType::Vec3:
+		Buffer.append("vec3(");
+		break;
+	case ShaderPropertyType::Vec4:
+		Buffer.append("vec4(");
+		break;
+	}
+
+	for (int count = 0; count < ShaderPropertySize(Type); ++count) {
+		if (count != 0) {
+			Buffer.append(", ");
+		}
+		appendFloat(Data[count]);
+	}
+	Buffer.append(")");
+}
+const char *Shader::ParseUniform(const char *Cursor, const char *End) {
+	const char *begin = Cursor;
+
+	// @uniform(array) Type name;
+	auto directive = ReadIdentifier(Cursor, End);
+	if (directive != "uniform" || !ReadPunctuation(Cursor, End, '(') || ReadIdentifier(Cursor, End).empty() ||
+		!ReadPunctuation(Cursor, End, ')')) {
+		throw ShaderInvalidDirective(std::string(begin, std::find(begin, End, '\n')).c_str());
+	}
+
+	auto type = ReadIdentifier(Cursor, End);
+	auto name = ReadIdentifier(Cursor, End);
+	if (type.empty() || name.empty() || !ReadPunctuation(Cursor, End, ';')) {
+		throw ShaderInvalidDirective(std::string(begin, std::find(begin, End, '\n')).c_str());
+	}
+
+	_segments.push_back({SegmentKind::Uniform, std::string(name), std::string(type)});
+
+	return Cursor;
+}
+void Shader::Parse() {
+	const char *cursor = _code.data();
+	const char *end	   = cursor + _code.size();
+	// The begin of the span which is copied to the output verbatim
+	const char *span   = cursor;
+
+	std::string literal;
+	auto		flushLiteral = [&]() {
+		if (!literal.empty()) {
+			_literalSize += literal.size();
+			_segments.push_back({SegmentKind::Literal, std::move(literal), {}});
+			literal.clear();
+		}
+	};
+
+	_segments.clear();
+	_literalSize = 0;
+	while (cursor < end) {
+		if (auto skipped = SkipCommentOrString(cursor, end); skipped != cursor) {
+			// Comments are dropped, they may contain characters that the SKSL compiler refuses
+			if (*cursor == '/') {
+				literal.append(span, cursor);
+				literal.append(cursor[1] == '/' ? "\n" : " ");
+				span = skipped;
 			}
-		} else {
-			switch (lexer.token) {
-			case CLEX_id:
-				result.append(lexer.string);
-				break;
-			case CLEX_eq:
-				result.append("==");
-				break;
-			case CLEX_noteq:
-				result.append("!=");
-				break;
-			case CLEX_lesseq:
-				result.append("<=");
-				break;
-			case CLEX_greatereq:
-				result.append(">=");
-				break;
-			case CLEX_andand:
-				result.append("&&");
-				break;
-			case CLEX_oror:
-				result.append("||");
-				break;
-			case CLEX_shl:
-				result.append("<<");
-				break;
-			case CLEX_shr:
-				result.append(">>");
-				break;
-			case CLEX_plusplus:
-				result.append("++");
-				break;
-			case CLEX_minusminus:
-				result.append("--");
-				break;
-			case CLEX_arrow:
-				result.append("->");
-				break;
-			case CLEX_andeq:
-				result.append("&=");
-				break;
-			case CLEX_oreq:
-				result.append("|=");
-				break;
-			case CLEX_xoreq:
-				result.append("^=");
-				break;
-			case CLEX_pluseq:
-				result.append("+=");
-				break;
-			case CLEX_minuseq:
-				result.append("-=");
-				break;
-			case CLEX_muleq:
-				result.append("*=");
-				break;
-			case CLEX_diveq:
-				result.append("/=");
-				break;
-			case CLEX_modeq:
-				result.append("%%=");
-				break;
-			case CLEX_shleq:
-				result.append("<<=");
-				break;
-			case CLEX_shreq:
-				result.append(">>=");
-				break;
-			case CLEX_eqarrow:
-				result.append("=>");
-				break;
-			case CLEX_dqstring:
-				result.append(std::format("\"{}\"", lexer.string));
-				break;
-			case CLEX_sqstring:
-				result.append(std::format("'\"{}\"'", lexer.string));
-				break;
-			case CLEX_charlit:
-				result.append(std::format("'{}'", lexer.string));
-				break;
-			case CLEX_intlit:
-				result.append(std::format("{}", lexer.int_number));
-				break;
-			case CLEX_floatlit:
-				result.append(std::format("{}", lexer.real_number));
-				break;
-			default:
-				result.append(std::format("{}", char(lexer.token)));
-				break;
+			cursor = skipped;
+		} else if (*cursor == '$') {
+			// $tag$
+			const char *begin = cursor++;
+			while (cursor < end && IsIdentifier(*cursor) && *cursor != '$') {
+				++cursor;
+			}
+			if (cursor < end && *cursor == '$') {
+				++cursor;
 			}
 
-			result.append(" ");
+			literal.append(span, begin);
+			flushLiteral();
+			_segments.push_back({SegmentKind::Variable, std::string(begin, cursor), {}});
+			span = cursor;
+		} else if (*cursor == '@') {
+			literal.append(span, cursor);
+			flushLiteral();
+			cursor = ParseUniform(cursor + 1, end);
+			span   = cursor;
+		} else {
+			// Jump to the next character which may start a comment, a string or a rewriting site
+			++cursor;
+			while (cursor < end && !SpecialCharacter[static_cast<unsigned char>(*cursor)]) {
+				++cursor;
+			}
 		}
 	}
+	literal.append(span, end);
+	flushLiteral();
 
-	result.append("\nvoid init_vedo() {\n");
-	for (auto& uniform : _uniformReplacement) {
-		result.append(std::format("func_init_{}();\n", uniform.first));
+	_parsed = true;
+}
+void Shader::Preprocess(std::string &Output) {
+	if (!_parsed) {
+		Parse();
 	}
-	result.append("\n}");
 
-	printf("%s\n", result.c_str());
+	// Reserve for the code and the generated uniform code, the capacity of the output is kept when
+	// it is reused, so the estimation only matters for the first time
+	size_t generatedSize = 256;
+	for (auto &[name, array] : _uniformReplacement) {
+		generatedSize += 256 + (array.Mode == ShaderUniformMode::Inline ? array.Structures.size() * 512 : 0);
+	}
+	Output.clear();
+	Output.reserve(_literalSize + generatedSize);
 
-	_flushall();
+	Output.append("void init_vedo();\n");
+
+	// Linking is only a concatenation of the parsed segments and the bound values
+	for (auto &segment : _segments) {
+		switch (segment.Kind) {
+		case SegmentKind::Literal: {
+			Output.append(segment.Text);
+			break;
+		}
+		case SegmentKind::Variable: {
+			auto replacement = _linkReplacement.find(segment.Text);
+			if (replacement == _linkReplacement.end()) {
+				throw ShaderInvalidVariable(segment.Text.c_str());
+			}
+
+			Output.append(replacement->second);
+			break;
+		}
+		case SegmentKind::Uniform: {
+			auto array = _uniformReplacement.find(segment.Text);
+			if (array == _uniformReplacement.end()) {
+				throw ShaderInvalidUniform(segment.Text.c_str());
+			}
 
-	return result;
+			if (array->second.Mode == ShaderUniformMode::Packed) {
+				// The code of a packed array only depends on its layout, it is kept until the layout changes
+				if (array->second.Code.empty()) {
+					PackedUniformCode(array->second.Code, segment.Text, segment.StructureType, array->second);
+				}
+				Output.append(array->second.Code);
+			} else {
+				InlineUniformCode(Output, segment.Text, segment.StructureType, array->second);
+			}
+			break;
+		}
+		}
+	}
+
+	Output.append("\nvoid init_vedo() {\n");
+	for (auto &uniform : _uniformReplacement) {
+		Output.append("func_init_").append(uniform.first).append("();\n");
+	}
+	Output.append("\n}");
 }
 } // namespace Vedo
\ No newline at end of file
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file VeShaderCache.cpp
+ * \brief The compiled shader cache of Vedo renderer
+ */
+
+#include <include/shader/VeShaderCache.h>
+
+namespace Vedo {
+ShaderCache &ShaderCache::Instance() {
+	static ShaderCache cache;
+
+	return cache;
+}
+sk_sp<SkRuntimeEffect> ShaderCache::MakeEffect(const std::string &Code) {
+	const auto hash = Hash(Code);
+	{
+		std::lock_guard lock(_mutex);
+		if (auto effect = Find(hash, Code)) {
+			return effect;
+		}
+	}
+
+	// Compile out of the lock, so that different shaders can be compiled by different threads
+	auto [effect, error] = SkRuntimeEffect::MakeForShader(SkString(Code.c_str()));
+	if (!error.isEmpty()) {
+		throw ShaderCreateFailure(error.c_str());
+	}
+
+	// Another thread may have compiled the same code meanwhile, its effect is kept instead
+	std::lock_guard lock(_mutex);
+	if (auto cached = Find(hash, Code)) {
+		return cached;
+	}
+	if (_effects.size() >= MaxEffect) {
+		_effects.erase(std::ranges::min_element(_effects, {}, [](const auto &Entry) { return Entry.second.LastUse; }));
+	}
+	_effects.emplace(hash, Entry{Code, effect, ++_use});
+
+	return effect;
+}
+void ShaderCache::Purge() {
+	std::lock_guard lock(_mutex);
+	_effects.clear();
+}
+size_t ShaderCache::Size() {
+	std::lock_guard lock(_mutex);
+	return _effects.size();
+}
+sk_sp<SkRuntimeEffect> ShaderCache::Find(uint64_t Hash, const std::string &Code) {
+	auto [begin, end] = _effects.equal_range(Hash);
+	for (auto iterator = begin; iterator != end; ++iterator) {
+		// The hash may collide, the code is compared to make sure the effect is right
+		if (iterator->second.Code == Code) {
+			iterator->second.LastUse = ++_use;
+
+			return iterator->second.Effect;
+		}
+	}
+
+	return nullptr;
+}
+uint64_t ShaderCache::Hash(std::string_view Code) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (auto character : Code) {
+		hash ^= static_cast<uint8_t>(character);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+ShaderDiskCache::ShaderDiskCache(std::filesystem::path Directory) : _directory(std::move(Directory)) {
+	std::error_code error;
+	std::filesystem::create_directories(_directory, error);
+}
+sk_sp<SkData> ShaderDiskCache::load(const SkData &Key) {
+	std::lock_guard lock(_mutex);
+	std::ifstream	stream(KeyPath(Key), std::ios::binary | std::ios::ate);
+	if (!stream.is_open()) {
+		return nullptr;
+	}
+
+	// The file name is only a hash of the key, the key stored ahead of the data is compared to
+	// make sure a collision will not hand a wrong program to Skia
+	auto	 fileSize = static_cast<uint64_t>(stream.tellg());
+	uint64_t keySize  = 0;
+	stream.seekg(0);
+	if (!stream.read(reinterpret_cast<char *>(&keySize), sizeof(keySize)) || keySize != Key.size() ||
+		fileSize < sizeof(keySize) + keySize) {
+		return nullptr;
+	}
+
+	std::string key(keySize, '\0');
+	if (!stream.read(key.data(), static_cast<std::streamsize>(keySize)) ||
+		memcmp(key.data(), Key.data(), keySize) != 0) {
+		return nullptr;
+	}
+
+	auto data = SkData::MakeUninitialized(fileSize - sizeof(keySize) - keySize);
+	if (!stream.read(static_cast<char *>(data->writable_data()), static_cast<std::streamsize>(data->size()))) {
+		return nullptr;
+	}
+
+	return data;
+}
+void ShaderDiskCache::store(const SkData &Key, const SkData &Data) {
+	std::lock_guard lock(_mutex);
+	std::ofstream	stream(KeyPath(Key), std::ios::binary | std::ios::trunc);
+	if (stream.is_open()) {
+		uint64_t keySize = Key.size();
+		stream.write(reinterpret_cast<const char *>(&keySize), sizeof(keySize));
+		stream.write(static_cast<const char *>(Key.data()), static_cast<std::streamsize>(Key.size()));
+		stream.write(static_cast<const char *>(Data.data()), static_cast<std::streamsize>(Data.size()));
+	}
+}
+std::filesystem::path ShaderDiskCache::KeyPath(const SkData &Key) const {
+	auto hash = ShaderCache::Hash(std::string_view(static_cast<const char *>(Key.data()), Key.size()));
+
+	return _directory / std::format("{:016x}.vsc", hash);
+}
+} // namespace Vedo
@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The tester for Vedo BVH
+ */
+
+#include <include/render/VeBVH.h>
+#include <include/render/VeMesh.h>
+
+#include <bit>
+#include <chrono>
+#include <random>
+
+/**
+ * The rows of a texture every GPU can bind, the least maximal texture size required by OpenGL ES 3.0
+ */
+constexpr size_t TextureRowLimit = 2048;
+
+/**
+ * Get the rows of the node texture of the nodes, which is Vedo::MeshBuffer::TextureWidth texels wide
+ */
+size_t TextureRows(size_t NodeCount) {
+	auto texels = NodeCount * Vedo::BVH::NodeTexelCount;
+
+	return (texels + Vedo::MeshBuffer::TextureWidth - 1) / Vedo::MeshBuffer::TextureWidth;
+}
+
+/**
+ * Check the structure of the BVH: the nodes are in depth-first order, every bound contains its
+ * children and every primitive is held by exactly one leaf
+ * @param Tree The BVH to be checked
+ * @param PrimitiveCount The count of the sphere objects, the count of the triangles when the
+ * objects are all meshes, or the count of the instances when the leaves are all instances
+ * @return Whether the BVH is valid
+ */
+bool CheckStructure(const Vedo::BVH &Tree, int PrimitiveCount) {
+	auto			 &nodes = Tree.Nodes();
+	std::vector<int> held(PrimitiveCount, 0);
+
+	auto contains = [](const Vedo::BVHNode &Parent, const Vedo::BVHNode &Child) {
+		return Parent.BoundMin.x <= Child.BoundMin.x && Parent.BoundMin.y <= Child.BoundMin.y &&
+			   Parent.BoundMin.z <= Child.BoundMin.z && Parent.BoundMax.x >= Child.BoundMax.x &&
+			   Parent.BoundMax.y >= Child.BoundMax.y && Parent.BoundMax.z >= Child.BoundMax.z;
+	};
+
+	for (int index = 0; index < static_cast<int>(nodes.size()); ++index) {
+		auto &node = nodes[index];
+		if (node.Escape <= index || node.Escape > static_cast<int>(nodes.size())) {
+			return false;
+		}
+		if (node.Object >= 0) {
+			if (node.Escape != index + 1) {
+				return false;
+			}
+			auto primitive = node.Instance >= 0 ? node.Instance : (node.Triangle >= 0 ? node.Triangle : node.Object);
+			if (primitive >= PrimitiveCount) {
+				return false;
+			}
+			++held[primitive];
+
+			continue;
+		}
+		// Every node inside the subtree should be contained by the bound
+		for (int child = index + 1; child < node.Escape; ++child) {
+			if (!contains(node, nodes[child])) {
+				return false;
+			}
+		}
+	}
+
+	return std::all_of(held.begin(), held.end(), [](int Count) { return Count == 1; });
+}
+
+/**
+ * Whether the ray hits the sphere of the object
+ */
+bool HitObject(const Vedo::Object &Target, const Vedo::Vec3 &Origin, const Vedo::Vec3 &Direction) {
+	auto origin = Origin - Target.Center;
+	auto a		= Direction.dot(Direction);
+	auto halfB	= origin.dot(Direction);
+	auto c		= origin.dot(origin) - Target.Radius * Target.Radius;
+	auto delta	= halfB * halfB - a * c;
+	if (delta < 0) {
+		return false;
+	}
+
+	return (-halfB + std::sqrt(delta)) / a >= 0.001f;
+}
+
+/**
+ * Whether the ray hits the bound, the same slab test as the shader, the far distance is scaled up by
+ * the rounding error so the ray grazing the bound is never lost
+ */
+bool HitBound(const Vedo::BVHNode &Node, const Vedo::Vec3 &Origin, const Vedo::Vec3 &Direction) {
+	float tNear = 0.001f;
+	float tFar	= 9999999.f;
+	for (int axis = 0; axis < 3; ++axis) {
+		auto inverse = 1.f / Direction[axis];
+		auto t0		 = (Node.BoundMin[axis] - Origin[axis]) * inverse;
+		auto t1		 = (Node.BoundMax[axis] - Origin[axis]) * inverse;
+		tNear		 = std::max(tNear, std::min(t0, t1));
+		tFar		 = std::min(tFar, std::max(t0, t1));
+	}
+
+	return tNear <= tFar * 1.0000004f;
+}
+
+/**
+ * Walk the BVH of a mesh like the shader, the first leaf the ray hits ends the walk
+ * @return Whether the ray hits any triangle
+ */
+bool WalkMesh(const Vedo::BVH &Tree, const Vedo::Mesh &Target, const Vedo::Vec3 &Origin, const Vedo::Vec3 &Direction) {
+	auto &nodes = Tree.Nodes();
+	for (int index = 0; index < static_cast<int>(nodes.size());) {
+		auto &node = nodes[index];
+		if (!HitBound(node, Origin, Direction)) {
+			index = node.Escape;
+		} else if (node.Object < 0) {
+			++index;
+		} else if (Target.Intersect(node.Triangle, Origin, Direction, 0.001f, 9999999.f)) {
+			return true;
+		} else {
+			index = node.Escape;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Test the BVH of the triangle meshes, the walk should agree with the brute force loop, and the
+ * rays through the shared edges and vertices of a closed grid should never leak
+ * @param Random The random engine
+ * @return Whether the test passes
+ */
+bool TestMesh(std::mt19937 &Random) {
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	std::uniform_real_distribution<float> offset(-2.f, 2.f);
+	std::uniform_real_distribution<float> height(-0.2f, 0.2f);
+
+	// The triangles of the soup do not share any vertex
+	auto soup = Vedo::Mesh::Make();
+	for (int triangle = 0; triangle < 20000; ++triangle) {
+		auto center = Vedo::Vec3{position(Random), position(Random), position(Random)};
+		auto first	= soup->AddVertex(center + Vedo::Vec3{offset(Random), offset(Random), offset(Random)});
+		auto second = soup->AddVertex(center + Vedo::Vec3{offset(Random), offset(Random), offset(Random)});
+		auto third	= soup->AddVertex(center + Vedo::Vec3{offset(Random), offset(Random), offset(Random)});
+		soup->AddTriangle(first, second, third);
+	}
+
+	Vedo::Object soupObject;
+	soupObject.Shape	= Vedo::MeshGeometry;
+	soupObject.Geometry = soup.get();
+
+	auto soupCount = static_cast<int>(soup->TriangleCount());
+	auto soupTree  = Vedo::BVH::MakeParallel(std::vector<Vedo::Object *>{&soupObject});
+	if (!CheckStructure(*soupTree, soupCount)) {
+		printf("The BVH of %d triangles is invalid.\n", soupCount);
+
+		return false;
+	}
+
+	int mismatch = 0;
+	for (int ray = 0; ray < 2000; ++ray) {
+		auto origin	   = Vedo::Vec3{position(Random), position(Random), position(Random)};
+		auto target	   = soup->TriangleBound(ray % soupCount).Centroid();
+		auto direction = target - origin;
+
+		bool bruteForce = false;
+		for (int triangle = 0; triangle < soupCount && !bruteForce; ++triangle) {
+			bruteForce = soup->Intersect(triangle, origin, direction, 0.001f, 9999999.f).has_value();
+		}
+
+		mismatch += WalkMesh(*soupTree, *soup, origin, direction) != bruteForce;
+	}
+
+	// Moving the vertices slightly only refits the tree
+	for (uint32_t vertex = 0; vertex < soup->VertexCount(); ++vertex) {
+		soup->SetVertex(vertex, soup->Vertex(vertex) + Vedo::Vec3{height(Random), height(Random), height(Random)});
+	}
+	soupTree->Update({&soupObject});
+	if (!CheckStructure(*soupTree, soupCount)) {
+		printf("The refitted BVH of %d triangles is invalid.\n", soupCount);
+
+		return false;
+	}
+
+	// The grid is made of the quads split in the alternate diagonals, with bumpy heights
+	constexpr int gridSize = 64;
+	auto		  grid	   = Vedo::Mesh::Make();
+	for (int y = 0; y <= gridSize; ++y) {
+		for (int x = 0; x <= gridSize; ++x) {
+			grid->AddVertex({static_cast<float>(x), static_cast<float>(y), height(Random)});
+		}
+	}
+	for (uint32_t y = 0; y < gridSize; ++y) {
+		for (uint32_t x = 0; x < gridSize; ++x) {
+			auto corner = y * (gridSize + 1) + x;
+			if ((x + y) % 2 == 0) {
+				grid->AddTriangle(corner, corner + 1, corner + gridSize + 2);
+				grid->AddTriangle(corner, corner + gridSize + 2, corner + gridSize + 1);
+			} else {
+				grid->AddTriangle(corner, corner + 1, corner + gridSize + 1);
+				grid->AddTriangle(corner + 1, corner + gridSize + 2, corner + gridSize + 1);
+			}
+		}
+	}
+
+	Vedo::Object gridObject;
+	gridObject.Shape	= Vedo::MeshGeometry;
+	gridObject.Geometry = grid.get();
+
+	auto gridTree = Vedo::BVH::Make({&gridObject});
+	if (!CheckStructure(*gridTree, static_cast<int>(grid->TriangleCount()))) {
+		printf("The BVH of the grid is invalid.\n");
+
+		return false;
+	}
+
+	// Aim at the inner vertices and the midpoints of the inner edges from random points above
+	std::uniform_int_distribution<int>	  inner(1, gridSize - 1);
+	std::uniform_real_distribution<float> above(-50.f, 50.f);
+	int									  leak = 0;
+	for (int ray = 0; ray < 20000; ++ray) {
+		auto vertex = static_cast<uint32_t>(inner(Random) * (gridSize + 1) + inner(Random));
+		auto target = grid->Vertex(vertex);
+		if (ray % 3 == 1) {
+			target = (target + grid->Vertex(vertex + 1)) * 0.5f;
+		} else if (ray % 3 == 2) {
+			target = (target + grid->Vertex(vertex + gridSize + 1)) * 0.5f;
+		}
+
+		auto origin = Vedo::Vec3{target.x + above(Random), target.y + above(Random), ray % 2 == 0 ? 30.f : -30.f};
+		leak += !WalkMesh(*gridTree, *grid, origin, target - origin);
+	}
+
+	printf("%d triangles: %zu nodes, %d mismatched rays, %d rays leaked through the grid.\n", soupCount,
+		   soupTree->Nodes().size(), mismatch, leak);
+
+	return mismatch == 0 && leak == 0;
+}
+
+/**
+ * Walk the two level BVH like the shader, an instance leaf walks the bottom level BVH of its prototype
+ * with the ray moved into the space of the prototype, the first leaf the ray hits ends the walk. The
+ * mesh should be the first object, so its triangles are numbered from 0
+ * @return Whether the ray hits any primitive
+ */
+bool WalkInstanced(const Vedo::BVH &Tree, const std::vector<Vedo::Object *> &Objects, const Vedo::Vec3 &Origin,
+				   const Vedo::Vec3 &Direction) {
+	auto hitLeaf = [&](const Vedo::BVHNode &Leaf, const Vedo::Vec3 &RayOrigin, const Vedo::Vec3 &RayDirection) {
+		auto &object = *Objects[Leaf.Object];
+		if (Leaf.Triangle >= 0) {
+			return object.Geometry->Intersect(Leaf.Triangle, RayOrigin, RayDirection, 0.001f, 9999999.f).has_value();
+		}
+
+		return HitObject(object, RayOrigin, RayDirection);
+	};
+	auto walk = [](const std::vector<Vedo::BVHNode> &Nodes, int First, int End, const Vedo::Vec3 &RayOrigin,
+				   const Vedo::Vec3 &RayDirection, auto &&Leaf) {
+		for (int index = First; index < End;) {
+			auto &node = Nodes[index];
+			if (!HitBound(node, RayOrigin, RayDirection)) {
+				index = node.Escape;
+			} else if (node.Object < 0) {
+				++index;
+			} else if (Leaf(node)) {
+				return true;
+			} else {
+				index = node.Escape;
+			}
+		}
+
+		return false;
+	};
+
+	auto &nodes = Tree.Nodes();
+	return walk(nodes, 0, static_cast<int>(nodes.size()), Origin, Direction, [&](const Vedo::BVHNode &Leaf) {
+		if (Leaf.Instance < 0) {
+			return hitLeaf(Leaf, Origin, Direction);
+		}
+
+		// The instance is read from the copy in its leaf like the shader
+		auto &instance = Leaf;
+		auto  offset   = Origin - instance.Translation;
+		auto  origin   = Vedo::Vec3{instance.InverseX.dot(offset), instance.InverseY.dot(offset),
+								instance.InverseZ.dot(offset)};
+		auto  direction = Vedo::Vec3{instance.InverseX.dot(Direction), instance.InverseY.dot(Direction),
+								   instance.InverseZ.dot(Direction)};
+
+		auto &bottom = Tree.BottomNodes();
+		return walk(bottom, instance.Root, bottom[instance.Root].Escape, origin, direction,
+					[&](const Vedo::BVHNode &BottomLeaf) { return hitLeaf(BottomLeaf, origin, direction); });
+	});
+}
+
+/**
+ * Test the two level BVH of the instances of a mesh and a sphere against the brute force loop over all
+ * the instances, and compare its node textures with the scene where every instance is a copy
+ * @param Random The random generator
+ * @return Whether the test passes
+ */
+bool TestInstances(std::mt19937 &Random) {
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	std::uniform_real_distribution<float> scale(0.5f, 3.f);
+
+	auto soup = Vedo::Mesh::Make();
+	for (uint32_t triangle = 0; triangle < 300; ++triangle) {
+		auto center = Vedo::Vec3{unit(Random), unit(Random), unit(Random)};
+		for (int corner = 0; corner < 3; ++corner) {
+			soup->AddVertex(center + Vedo::Vec3{unit(Random), unit(Random), unit(Random)} * 0.3f);
+		}
+		soup->AddTriangle(triangle * 3, triangle * 3 + 1, triangle * 3 + 2);
+	}
+
+	Vedo::Object meshPrototype;
+	meshPrototype.Shape	   = Vedo::MeshGeometry;
+	meshPrototype.Geometry = soup.get();
+	meshPrototype.Material = 0;
+
+	Vedo::Object spherePrototype;
+	spherePrototype.Shape	 = Vedo::SphereGeometry;
+	spherePrototype.Center	 = Vedo::Vec3{0, 0, 0};
+	spherePrototype.Radius	 = 1;
+	spherePrototype.Material = 1;
+
+	Vedo::Object placed;
+	placed.Shape	= Vedo::SphereGeometry;
+	placed.Center	= Vedo::Vec3{0, 0, 0};
+	placed.Radius	= 5;
+	placed.Material = 2;
+
+	constexpr int				 instanceCount = 4000;
+	std::vector<Vedo::Instance>	 instances(instanceCount);
+	std::vector<Vedo::Instance *> instancePointers;
+	for (int index = 0; index < instanceCount; ++index) {
+		auto axis				   = Vedo::Vec3{unit(Random), unit(Random), unit(Random)} + Vedo::Vec3{0, 2, 0};
+		instances[index].Object	   = index % 2;
+		instances[index].Transform = Vedo::Matrix::Translate(position(Random), position(Random), position(Random)) *
+									 Vedo::Matrix::Rotate(axis, unit(Random) * 3.f) *
+									 Vedo::Matrix::Scale(scale(Random), scale(Random), scale(Random));
+		instances[index].Material  = index % 3 == 0 ? 3 : -1;
+		instancePointers.push_back(&instances[index]);
+	}
+
+	std::vector<Vedo::Object *> objects = {&meshPrototype, &spherePrototype};
+	auto						onlyInstances = Vedo::BVH::MakeInstanced(objects, instancePointers);
+	if (!CheckStructure(*onlyInstances, instanceCount)) {
+		printf("The top level BVH of %d instances is invalid.\n", instanceCount);
+
+		return false;
+	}
+
+	objects.push_back(&placed);
+	auto tree = Vedo::BVH::MakeInstanced(objects, instancePointers);
+
+	auto check = [&](int RayCount) {
+		int mismatch = 0;
+		for (int ray = 0; ray < RayCount; ++ray) {
+			auto &target	= instances[ray % instanceCount].Transform;
+			auto  origin	= Vedo::Vec3{position(Random), position(Random), position(Random)};
+			auto  direction = Vedo::Vec3{target.rc(0, 3), target.rc(1, 3), target.rc(2, 3)} - origin;
+
+			bool bruteForce = HitObject(placed, origin, direction);
+			for (auto &instance : instances) {
+				Vedo::Matrix inverse;
+				instance.Transform.invert(&inverse);
+				auto localOrigin	= inverse.map(origin.x, origin.y, origin.z, 1);
+				auto localDirection = inverse.map(direction.x, direction.y, direction.z, 0);
+				auto rayOrigin		= Vedo::Vec3{localOrigin.x, localOrigin.y, localOrigin.z};
+				auto rayDirection	= Vedo::Vec3{localDirection.x, localDirection.y, localDirection.z};
+				if (instance.Object == 1) {
+					bruteForce |= HitObject(spherePrototype, rayOrigin, rayDirection);
+
+					continue;
+				}
+				for (uint32_t triangle = 0; triangle < soup->TriangleCount() && !bruteForce; ++triangle) {
+					bruteForce |= soup->Intersect(triangle, rayOrigin, rayDirection, 0.001f, 9999999.f).has_value();
+				}
+			}
+
+			mismatch += WalkInstanced(*tree, objects, origin, direction) != bruteForce;
+		}
+
+		return mismatch;
+	};
+
+	// Every leaf takes the material of its instance, or the material of its object without an override
+	auto wrongMaterial = [&]() {
+		int wrong = 0;
+		for (auto &node : tree->Nodes()) {
+			if (node.Object < 0) {
+				continue;
+			}
+
+			auto expected = node.Instance >= 0 && instances[node.Instance].Material >= 0
+								? instances[node.Instance].Material
+								: objects[node.Object]->Material;
+			wrong += node.Material != expected;
+		}
+
+		return wrong;
+	};
+
+	auto mismatch = check(500) + wrongMaterial();
+
+	// The node textures of the scene where every instance is a copy of its prototype, the instances and
+	// the materials are read from the leaves. Both textures of the instances must be bindable, and the
+	// walk of an instance is bounded by the nodes of the mesh, the largest prototype
+	auto copyPrimitives = static_cast<size_t>(instanceCount / 2) * (soup->TriangleCount() + 1) + 1;
+	auto copyRows		= TextureRows(copyPrimitives * 2 - 1);
+	auto topRows		= TextureRows(tree->Nodes().size());
+	auto bottomRows		= TextureRows(tree->BottomNodes().size());
+	auto bottomLimit	= static_cast<size_t>(tree->BottomNodeLimit());
+
+	printf("%d instances: %zu top level and %zu bottom level nodes built in %.3f ms, textures of %zu and %zu rows "
+		   "instead of %zu for the copies, %zu steps for an instance, %d mismatched rays and materials.\n",
+		   instanceCount, tree->Nodes().size(), tree->BottomNodes().size(), tree->BuildTime(), topRows, bottomRows,
+		   copyRows, bottomLimit, mismatch);
+	if (mismatch != 0 || topRows > TextureRowLimit || bottomRows > TextureRowLimit ||
+		(topRows + bottomRows) * 10 > copyRows || bottomLimit != std::bit_ceil(soup->TriangleCount() * 2 - 1)) {
+		return false;
+	}
+
+	// Moving the instances only builds the top level BVH again, the overrides of the materials are
+	// changed along with them
+	for (auto &instance : instances) {
+		instance.Transform = Vedo::Matrix::Translate(unit(Random), unit(Random), unit(Random)) * instance.Transform;
+		instance.Material  = instance.Material >= 0 ? -1 : 4;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	tree->Update(objects, instancePointers);
+	auto end = std::chrono::steady_clock::now();
+
+	mismatch = check(200) + wrongMaterial();
+	printf("%d instances: moved in %.3f ms, %d mismatched rays and materials.\n", instanceCount,
+		   std::chrono::duration<double, std::milli>(end - start).count(), mismatch);
+
+	return mismatch == 0;
+}
+
+int main() {
+	std::mt19937						  random(20231);
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	std::uniform_real_distribution<float> radius(0.1f, 2.f);
+
+	for (int count : {1, 2, 3, 100, 10000, 100000, 1000000}) {
+		std::vector<Vedo::Object>	objects(count);
+		std::vector<Vedo::Object *> objectPointers;
+		for (auto &object : objects) {
+			object.Shape  = Vedo::SphereGeometry;
+			object.Center = Vedo::Vec3{position(random), position(random), position(random)};
+			object.Radius = radius(random);
+			objectPointers.push_back(&object);
+		}
+
+		auto tree	  = Vedo::BVH::Make(objectPointers);
+		auto parallel = Vedo::BVH::MakeParallel(objects);
+
+		if (!CheckStructure(*tree, count) || !CheckStructure(*parallel, count)) {
+			printf("The BVH of %d objects is invalid.\n", count);
+
+			return -1;
+		}
+
+		// The stackless walk should find a hit exactly when the brute force loop does
+		auto check = [&](std::initializer_list<const Vedo::BVH *> Trees) {
+			int mismatch = 0;
+			int tested	 = std::min(count, 1000);
+			int rayCount = std::clamp(100000000 / count, 20, 2000);
+			for (int ray = 0; ray < rayCount; ++ray) {
+				auto origin	   = Vedo::Vec3{position(random), position(random), position(random)};
+				auto direction = objects[ray % tested].Center - origin;
+
+				bool bruteForce = false;
+				for (auto &object : objects) {
+					bruteForce |= HitObject(object, origin, direction);
+				}
+
+				for (auto bvh : Trees) {
+					bool  walk	= false;
+					auto &nodes = bvh->Nodes();
+					for (int index = 0; index < static_cast<int>(nodes.size()) && !walk;) {
+						auto &node = nodes[index];
+						if (!HitBound(node, origin, direction)) {
+							index = node.Escape;
+						} else if (node.Object < 0) {
+							++index;
+						} else {
+							walk  = HitObject(objects[node.Object], origin, direction);
+							index = node.Escape;
+						}
+					}
+
+					mismatch += walk != bruteForce;
+				}
+			}
+
+			return mismatch;
+		};
+
+		auto mismatch = check({tree.get(), parallel.get()});
+
+		printf("%d objects: %zu nodes, built in %.3f ms on one thread and %.3f ms in parallel, %d mismatched "
+			   "rays.\n",
+			   count, tree->Nodes().size(), tree->BuildTime(), parallel->BuildTime(), mismatch);
+		if (mismatch != 0) {
+			return -1;
+		}
+
+		// Animate the spheres slightly, the refit keeps the tree valid without a rebuild
+		std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+		for (auto &object : objects) {
+			object.Center = object.Center + Vedo::Vec3{jitter(random), jitter(random), jitter(random)};
+		}
+
+		auto start	 = std::chrono::steady_clock::now();
+		auto rebuilt = tree->Update(objectPointers);
+		auto end	 = std::chrono::steady_clock::now();
+		if (rebuilt) {
+			printf("The BVH of %d slightly moved objects is rebuilt instead of refitted.\n", count);
+
+			return -1;
+		}
+		if (!CheckStructure(*tree, count) || check({tree.get()}) != 0) {
+			printf("The refitted BVH of %d objects is invalid.\n", count);
+
+			return -1;
+		}
+
+		// Scatter the spheres, the cost of the refitted tree degrades so it should be rebuilt
+		for (auto &object : objects) {
+			object.Center = Vedo::Vec3{position(random), position(random), position(random)};
+		}
+		// A few spheres can not degrade the tree enough to be rebuilt, they are only checked by the rays
+		auto scattered = tree->Update(objectPointers);
+		if (count >= 100 && !scattered) {
+			printf("The BVH of %d scattered objects is refitted instead of rebuilt.\n", count);
+
+			return -1;
+		}
+		if (!CheckStructure(*tree, count) || check({tree.get()}) != 0) {
+			printf("The updated BVH of %d objects is invalid.\n", count);
+
+			return -1;
+		}
+
+		printf("%d objects: updated in %.3f ms (%s), scattered objects %s.\n", count,
+			   std::chrono::duration<double, std::milli>(end - start).count(), rebuilt ? "rebuilt" : "refitted",
+			   scattered ? "rebuilt" : "refitted");
+	}
+
+	if (!TestMesh(random)) {
+		return -1;
+	}
+	if (!TestInstances(random)) {
+		return -1;
+	}
+
+	return 0;
+}
\ No newline at end of file
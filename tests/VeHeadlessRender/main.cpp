@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The headless render of Vedo, it renders the test scene on the CPU and writes a PNG file
+ */
+
+#include <include/render/VeBVH.h>
+#include <include/render/VeCamera.h>
+#include <include/render/VeMesh.h>
+#include <include/render/VeObject.h>
+#include <include/render/VeNativeRender.h>
+#include <include/render/VeRender.h>
+#include <include/render/VeSceneFile.h>
+
+#include <chrono>
+
+/**
+ * Usage: vedoHeadlessRender [output.png] [spp] [threads] [shader|native] [scene.vedo|-] [threshold], threads
+ * is 0 for the count of the cores, "native" renders by the native SIMD render instead of the shader, the
+ * scene file written by vedoSceneConverter replaces the test scene, "-" keeps the test scene. A positive
+ * threshold turns the adaptive sampling on
+ */
+int main(int argc, char **argv) {
+	std::string output = argc > 1 ? argv[1] : "vedo.png";
+	int			spp	   = argc > 2 ? std::atoi(argv[2]) : 200;
+	int			thread = argc > 3 ? std::atoi(argv[3]) : 0;
+	bool		native = argc > 4 && std::string(argv[4]) == "native";
+	float		adapt  = argc > 6 ? static_cast<float>(std::atof(argv[6])) : 0.f;
+
+	Vedo::Camera testCamera;
+
+	testCamera.Ratio = 256.f / 192.f;
+	testCamera.Width = 640;
+	testCamera.Depth = 50;
+
+	testCamera.FOV		= 90;
+	testCamera.LookFrom = Vedo::Vec3(13, 2, 3);
+	testCamera.LookAt	= Vedo::Vec3(0, 0, 0);
+	testCamera.VUP		= Vedo::Vec3(0, 1, 0);
+
+	testCamera.DeFocusAngle	 = 0.6;
+	testCamera.FocusDistance = 10.f;
+
+	testCamera.Init();
+
+	Vedo::Material sphereMetal;
+	sphereMetal.Kind   = Vedo::MetalMaterial;
+	sphereMetal.Albedo = Vedo::Vec3(43.f / 255.f, 45.f / 255.f, 48.f / 255.f);
+	sphereMetal.Fuzz   = 2.f;
+
+	Vedo::Material groundMetal;
+	groundMetal.Kind   = Vedo::MetalMaterial;
+	groundMetal.Albedo = Vedo::Vec3(0.6f, 0.6f, 0.6f);
+	groundMetal.Fuzz   = 0.1f;
+
+	Vedo::MaterialTable testMaterials;
+
+	Vedo::Object sphere;
+	sphere.Center	= Vedo::Vec3(0, 0, 0);
+	sphere.Radius	= 7.5f;
+	sphere.Material = testMaterials.Add(sphereMetal);
+	sphere.Shape	= Vedo::SphereGeometry;
+
+	// The ground under the sphere is a quad mesh of two triangles
+	auto groundMesh =
+		Vedo::Mesh::Make({Vedo::Vec3(-100, -7.5f, -100), Vedo::Vec3(100, -7.5f, -100), Vedo::Vec3(100, -7.5f, 100),
+						  Vedo::Vec3(-100, -7.5f, 100)},
+						 {0, 2, 1, 0, 3, 2});
+
+	Vedo::Object ground;
+	ground.Material = testMaterials.Add(groundMetal);
+	ground.Shape	= Vedo::MeshGeometry;
+	ground.Geometry = groundMesh.get();
+
+	try {
+		// The scene file is mapped and handed to the render as it is, its BVH is not built again
+		std::unique_ptr<Vedo::SceneFile> scene;
+		std::unique_ptr<Vedo::BVH>		 bvh;
+		std::vector<Vedo::Object *>		 objects   = {&sphere, &ground};
+		auto							 camera	   = &testCamera;
+		auto							 materials = &testMaterials;
+		if (argc > 5 && std::string(argv[5]) != "-") {
+			scene	  = Vedo::SceneFile::Open(argv[5]);
+			objects	  = scene->Objects();
+			bvh		  = scene->MakeBVH();
+			camera	  = &scene->SceneCamera();
+			materials = &scene->Materials();
+		} else {
+			bvh = Vedo::BVH::Make(objects);
+		}
+		camera->SPP				  = static_cast<float>(std::max(spp, 1));
+		camera->Sampler			  = Vedo::SobolSampler;
+		camera->AdaptiveThreshold = adapt;
+
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point end;
+		int									  sample;
+		int64_t								  sampleCount = 0;
+		int64_t								  savedSample = 0;
+
+		if (native) {
+			// The same scene traced by the native SIMD render, without the shader
+			auto render = Vedo::NativeRender::Make(*camera, *materials, objects, std::move(bvh), 4, 64, thread);
+
+			start = std::chrono::steady_clock::now();
+			render->Converge();
+			end	   = std::chrono::steady_clock::now();
+			sample = render->Sample();
+			if (render->Adaptive() != nullptr) {
+				sampleCount = render->Adaptive()->SampleCount();
+				savedSample = render->Adaptive()->SavedSample();
+			}
+
+			render->Save(output);
+		} else {
+			std::vector<Vedo::IShaderStructureUniform *> cameraUniform = {camera};
+
+			auto meshes = Vedo::MeshBuffer::Make(objects);
+
+			auto shader = Vedo::Shader::MakeFromFile("../shaders/path_tracing.sksl");
+
+			shader->BindUniform("u_Depth", int(camera->Depth));
+			shader->BindUniformArray("u_camera", cameraUniform, Vedo::ShaderUniformMode::Packed);
+			shader->BindUniformArray("u_material", materials->Uniforms(), Vedo::ShaderUniformMode::Packed);
+			shader->BindUniform("u_NodeLimit", bvh->NodeLimit());
+			shader->BindChild("u_bvh", bvh->MakeNodeShader());
+			shader->BindUniform("u_BottomNodeLimit", bvh->BottomNodeLimit());
+			shader->BindChild("u_blas", bvh->MakeBottomNodeShader());
+			shader->BindChild("u_vertex", meshes->MakeVertexShader());
+			shader->BindChild("u_index", meshes->MakeIndexShader());
+
+			// No GPU context is needed, the runtime effect is evaluated by the raster backend of Skia in tiles
+			auto render = Vedo::Render::MakeTiledRaster(std::move(shader), *camera, 4, 64, thread);
+
+			start = std::chrono::steady_clock::now();
+			render->Converge();
+			end	   = std::chrono::steady_clock::now();
+			sample = render->Sample();
+			if (render->Adaptive() != nullptr) {
+				sampleCount = render->Adaptive()->SampleCount();
+				savedSample = render->Adaptive()->SavedSample();
+			}
+
+			render->Save(output);
+		}
+
+		auto second = std::chrono::duration<double>(end - start).count();
+		auto pixel	= static_cast<double>(camera->Width) * static_cast<int>(camera->Width / camera->Ratio);
+		printf("Rendered %d spp by the %s render in %.2f s (%.2f M samples/s), saved to %s\n", sample,
+			   native ? "native" : "shader", second, pixel * sample / second / 1e6, output.c_str());
+		if (sampleCount > 0) {
+			// The passes are counted by the noisiest pixel, the samples by every pixel
+			printf("Adaptive sampling took %.2f spp on average (%.2f M samples/s), %.2f M samples saved by the "
+				   "converged pixels\n",
+				   static_cast<double>(sampleCount) / pixel, static_cast<double>(sampleCount) / second / 1e6,
+				   static_cast<double>(savedSample) / 1e6);
+		}
+	} catch (std::exception &e) {
+		printf("Error occurred: %s.", e.what());
+
+		return -1;
+	}
+
+	return 0;
+}
\ No newline at end of file
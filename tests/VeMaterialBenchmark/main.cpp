@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The benchmark of the materials of Vedo renders
+ */
+
+#include <include/render/VeBVH.h>
+#include <include/render/VeMesh.h>
+#include <include/render/VeNativeRender.h>
+#include <include/render/VeRender.h>
+
+#include <chrono>
+
+/**
+ * Converge the render and report the throughput
+ * @tparam RenderType The render type, Vedo::NativeRender or Vedo::Render
+ * @param Name The name of the case
+ * @param Path The name of the render path
+ * @param RenderCamera The camera of the scene
+ * @param Target The render to be converged
+ */
+template <class RenderType>
+void Report(const char *Name, const char *Path, const Vedo::Camera &RenderCamera, RenderType &Target) {
+	const auto begin = std::chrono::steady_clock::now();
+	Target.Converge();
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+
+	// The height is decided by the camera in the same way
+	auto pixels	 = RenderCamera.Width * std::max(1.f, RenderCamera.Width / RenderCamera.Ratio);
+	auto samples = static_cast<double>(pixels) * Target.Sample();
+	printf("%-12s %-8s %4d spp in %9.2f ms, %8.2f M samples/s\n", Name, Path, Target.Sample(),
+		   duration.count() * 1000.0, samples / duration.count() / 1e6);
+}
+
+/**
+ * Render the scene by the native render and by the path tracing shader on the raster backend of
+ * Skia, so both the C++ mirror and the Scatter of the kernel are measured for the case
+ * @param Name The name of the case
+ * @param RenderCamera The camera of the scene
+ * @param Materials The material table of the scene
+ * @param Objects The objects of the scene
+ * @param ThreadCount The count of the worker threads
+ * @param Shader Whether the shader is measured as well
+ */
+void Measure(const char *Name, Vedo::Camera &RenderCamera, Vedo::MaterialTable &Materials,
+			 const std::vector<Vedo::Object *> &Objects, int ThreadCount, bool Shader) {
+	auto native = Vedo::NativeRender::Make(RenderCamera, Materials, Objects, 4, 64, ThreadCount);
+	Report(Name, "native", RenderCamera, *native);
+	if (!Shader) {
+		return;
+	}
+
+	std::vector<Vedo::IShaderStructureUniform *> cameraUniform = {&RenderCamera};
+
+	auto bvh	= Vedo::BVH::Make(Objects);
+	auto meshes = Vedo::MeshBuffer::Make(Objects);
+
+	auto shader = Vedo::Shader::MakeFromFile("../shaders/path_tracing.sksl");
+	shader->BindUniform("u_Depth", int(RenderCamera.Depth));
+	shader->BindUniformArray("u_camera", cameraUniform, Vedo::ShaderUniformMode::Packed);
+	shader->BindUniformArray("u_material", Materials.Uniforms(), Vedo::ShaderUniformMode::Packed);
+	shader->BindUniform("u_NodeLimit", bvh->NodeLimit());
+	shader->BindChild("u_bvh", bvh->MakeNodeShader());
+	shader->BindUniform("u_BottomNodeLimit", bvh->BottomNodeLimit());
+	shader->BindChild("u_blas", bvh->MakeBottomNodeShader());
+	shader->BindChild("u_vertex", meshes->MakeVertexShader());
+	shader->BindChild("u_index", meshes->MakeIndexShader());
+
+	auto render = Vedo::Render::MakeTiledRaster(std::move(shader), RenderCamera, 4, 64, ThreadCount);
+	Report(Name, "shader", RenderCamera, *render);
+}
+
+/**
+ * Usage: vedoBenchMaterial [spp] [threads] [native|both], threads is 0 for the count of the cores, "both"
+ * measures the path tracing shader on the raster backend of Skia after the native render
+ */
+int main(int argc, char **argv) {
+	int	 spp	= argc > 1 ? std::atoi(argv[1]) : 32;
+	int	 thread = argc > 2 ? std::atoi(argv[2]) : 0;
+	bool shader = argc <= 3 || std::string(argv[3]) != "native";
+
+	Vedo::Camera camera;
+	camera.Ratio		 = 4.f / 3.f;
+	camera.Width		 = 320;
+	camera.SPP			 = static_cast<float>(std::max(spp, 1));
+	camera.Depth		 = 16;
+	camera.FOV			 = 60;
+	camera.FocusDistance = 10;
+	camera.DeFocusAngle	 = 0;
+	camera.LookFrom		 = Vedo::Vec3{0, 4, 12};
+	camera.LookAt		 = Vedo::Vec3{0, 0, 0};
+	camera.VUP			 = Vedo::Vec3{0, 1, 0};
+	camera.Init();
+
+	// A grid of spheres on a large ground sphere, every object of a case shares the material under test
+	std::vector<Vedo::Object> objects(65);
+	for (int index = 0; index < 64; ++index) {
+		auto &sphere  = objects[index];
+		sphere.Shape  = Vedo::SphereGeometry;
+		sphere.Center = Vedo::Vec3{static_cast<float>(index % 8) * 1.2f - 4.2f, 0.f,
+								   static_cast<float>(index / 8) * 1.2f - 4.2f};
+		sphere.Radius = 0.5f;
+	}
+	auto &ground  = objects.back();
+	ground.Shape  = Vedo::SphereGeometry;
+	ground.Center = Vedo::Vec3{0, -1000.5f, 0};
+	ground.Radius = 1000;
+
+	std::vector<Vedo::Object *> pointers;
+	for (auto &object : objects) {
+		pointers.push_back(&object);
+	}
+
+	Vedo::Material lambert;
+	lambert.Kind   = Vedo::LambertMaterial;
+	lambert.Albedo = Vedo::Vec3{0.7f, 0.5f, 0.3f};
+
+	Vedo::Material metal;
+	metal.Kind	 = Vedo::MetalMaterial;
+	metal.Albedo = Vedo::Vec3{0.8f, 0.8f, 0.8f};
+	metal.Fuzz	 = 0.2f;
+
+	Vedo::Material dielectric;
+	dielectric.Kind			   = Vedo::DielectricMaterial;
+	dielectric.IndexRefraction = 1.5f;
+
+	try {
+		// The objects refer to the single shared material, which is changed in place between the cases
+		Vedo::MaterialTable shared;
+		auto				material = shared.Add(lambert);
+		for (auto &object : objects) {
+			object.Material = material;
+		}
+		Measure("lambert", camera, shared, pointers, thread, shader);
+		shared.Set(material, metal);
+		Measure("metal", camera, shared, pointers, thread, shader);
+		shared.Set(material, dielectric);
+		Measure("dielectric", camera, shared, pointers, thread, shader);
+
+		// The neighbouring spheres of different materials, the packets mix the kinds
+		Vedo::MaterialTable mixed;
+		int					kinds[3] = {mixed.Add(lambert), mixed.Add(metal), mixed.Add(dielectric)};
+		for (size_t index = 0; index < objects.size(); ++index) {
+			objects[index].Material = kinds[index % 3];
+		}
+		Measure("mixed", camera, mixed, pointers, thread, shader);
+	} catch (std::exception &e) {
+		printf("Error occurred: %s.", e.what());
+
+		exit(-1);
+	}
+
+	return 0;
+}
\ No newline at end of file
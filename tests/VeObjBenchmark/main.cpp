@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The benchmark for Vedo OBJ loader
+ */
+
+#include <include/render/VeObjLoader.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+/**
+ * Make the OBJ text of a bumpy grid with the texture coordinates and the normals, which are written
+ * like the exported assets, the faces are quads in "v/vt/vn" form
+ * @param Size The count of the quads along each side
+ * @return The OBJ text
+ */
+std::string MakeGrid(int Size) {
+	std::string text = "# Vedo OBJ benchmark grid\no grid\n";
+	for (int row = 0; row <= Size; ++row) {
+		for (int column = 0; column <= Size; ++column) {
+			auto x = static_cast<float>(column) / Size;
+			auto z = static_cast<float>(row) / Size;
+			text.append(std::format("v {:.6f} {:.6f} {:.6f}\nvt {:.6f} {:.6f}\nvn 0.000000 1.000000 0.000000\n", x,
+									0.05f * std::sin(x * 40.f) * std::cos(z * 40.f), z, x, z));
+		}
+	}
+	for (int row = 0; row < Size; ++row) {
+		for (int column = 0; column < Size; ++column) {
+			auto first	= row * (Size + 1) + column + 1;
+			auto second = first + Size + 1;
+			text.append(std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2} {3}/{3}/{3}\n", first, first + 1, second + 1,
+									second));
+		}
+	}
+
+	return text;
+}
+
+/**
+ * Parse the OBJ text by the stream extraction, which is what the loader replaces
+ * @param Text The OBJ text
+ * @return The count of the vertices and the triangles
+ */
+std::pair<size_t, size_t> ParseByStream(const std::string &Text) {
+	std::istringstream stream(Text);
+	std::string		   line;
+	size_t			   vertexCount	 = 0;
+	size_t			   triangleCount = 0;
+	while (std::getline(stream, line)) {
+		std::istringstream lineStream(line);
+		std::string		   statement;
+		lineStream >> statement;
+		if (statement == "v") {
+			float x, y, z;
+			lineStream >> x >> y >> z;
+			++vertexCount;
+		} else if (statement == "f") {
+			std::string corner;
+			int			corners = 0;
+			while (lineStream >> corner) {
+				std::stoi(corner);
+				++corners;
+			}
+			triangleCount += std::max(corners - 2, 0);
+		}
+	}
+
+	return {vertexCount, triangleCount};
+}
+
+/**
+ * Measure the throughput of a parser
+ * @param Name The name of the case
+ * @param Size The size of the text in bytes
+ * @param Parse The parser, returns the count of the vertices and the triangles
+ */
+template <class Function> void Measure(const char *Name, size_t Size, Function Parse) {
+	const int iteration = 3;
+	auto	  result	= Parse();
+
+	const auto begin = std::chrono::steady_clock::now();
+	for (int count = 0; count < iteration; ++count) {
+		result = Parse();
+	}
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+
+	const double seconds   = duration.count() / iteration;
+	const double megabytes = static_cast<double>(Size) / (1024.0 * 1024.0);
+	printf("%-24s %10zu vertices, %10zu triangles, %8.2f ms, %8.2f MiB/s\n", Name, result.first, result.second,
+		   seconds * 1000.0, megabytes / seconds);
+}
+
+/**
+ * Usage: vedoBenchObj [file.obj], the generated grid is measured without the file
+ */
+int main(int argc, char **argv) {
+	try {
+		std::string text;
+		if (argc > 1) {
+			std::ifstream file(argv[1], std::ios::binary);
+			if (!file.is_open()) {
+				throw Vedo::ObjOpenFailure(argv[1]);
+			}
+			text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		} else {
+			text = MakeGrid(1000);
+		}
+
+		printf("OBJ text of %.2f MiB\n", static_cast<double>(text.size()) / (1024.0 * 1024.0));
+
+		auto parse = [&](int ThreadCount) {
+			auto mesh = Vedo::ObjLoader::Parse(text, ThreadCount);
+			return std::make_pair(mesh->VertexCount(), mesh->TriangleCount());
+		};
+		Measure("stream extraction", text.size(), [&]() { return ParseByStream(text); });
+		Measure("loader, 1 thread", text.size(), [&]() { return parse(1); });
+		Measure("loader, all cores", text.size(), [&]() { return parse(0); });
+	} catch (std::exception &e) {
+		printf("Error occurred: %s.", e.what());
+
+		exit(-1);
+	}
+
+	return 0;
+}
\ No newline at end of file
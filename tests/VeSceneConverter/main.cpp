@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The converter from the text scene description to the binary scene file of Vedo
+ */
+
+#include <include/render/VeObjLoader.h>
+#include <include/render/VeSceneFile.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+/**
+ * The text scene has one statement per line, "#" starts a comment:
+ *
+ *     camera <ratio> <width> <spp> <depth> <fov> <focus distance> <defocus angle> <from xyz> <at xyz> <up xyz>
+ *     sphere <material> <center xyz> <radius> <albedo rgb> <fuzz> <index of refraction>
+ *     mesh <material> <albedo rgb> <fuzz> <index of refraction>
+ *     obj <material> <albedo rgb> <fuzz> <index of refraction> <path>
+ *     vertex <xyz>
+ *     triangle <first> <second> <third>
+ *
+ * The material is "lambert", "metal" or "dielectric", the objects of the same material share one
+ * record of the material table. The vertices and the triangles belong to the
+ * last mesh, the indices count from the first vertex of the mesh. The "obj" statement loads the mesh
+ * from an OBJ file, the path is relative to the scene file
+ */
+struct TextScene {
+	Vedo::Camera							   Camera;
+	Vedo::MaterialTable						   Materials;
+	std::vector<std::unique_ptr<Vedo::Object>> Objects;
+	std::vector<std::unique_ptr<Vedo::Mesh>>   Meshes;
+};
+
+int ParseMaterial(const std::string &Name) {
+	if (Name == "metal") {
+		return Vedo::MetalMaterial;
+	}
+	if (Name == "dielectric") {
+		return Vedo::DielectricMaterial;
+	}
+
+	return Vedo::LambertMaterial;
+}
+Vedo::Vec3 ParseVector(std::istringstream &Stream) {
+	Vedo::Vec3 vector{};
+	Stream >> vector.x >> vector.y >> vector.z;
+
+	return vector;
+}
+
+bool ParseScene(const std::string &Path, TextScene &Scene, int ThreadCount) {
+	std::ifstream file(Path);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::string line;
+	int			lineNumber = 0;
+	while (std::getline(file, line)) {
+		++lineNumber;
+
+		std::istringstream stream(line.substr(0, line.find('#')));
+		std::string		   statement;
+		if (!(stream >> statement)) {
+			continue;
+		}
+
+		if (statement == "camera") {
+			auto &camera = Scene.Camera;
+			stream >> camera.Ratio >> camera.Width >> camera.SPP >> camera.Depth >> camera.FOV >> camera.FocusDistance >>
+				camera.DeFocusAngle;
+			camera.LookFrom = ParseVector(stream);
+			camera.LookAt	= ParseVector(stream);
+			camera.VUP		= ParseVector(stream);
+		} else if (statement == "sphere" || statement == "mesh" || statement == "obj") {
+			auto		   object = std::make_unique<Vedo::Object>();
+			Vedo::Material material;
+			std::string	   kind;
+			stream >> kind;
+			material.Kind  = ParseMaterial(kind);
+			object->Center = Vedo::Vec3{0, 0, 0};
+			object->Radius = 0;
+			if (statement == "sphere") {
+				object->Shape  = Vedo::SphereGeometry;
+				object->Center = ParseVector(stream);
+				stream >> object->Radius;
+			}
+			material.Albedo = ParseVector(stream);
+			stream >> material.Fuzz >> material.IndexRefraction;
+			object->Material = Scene.Materials.Add(material);
+			if (statement == "obj") {
+				std::string objPath;
+				stream >> objPath;
+				if (!stream.fail()) {
+					auto loadPath = std::filesystem::path(Path).parent_path() / objPath;
+					Scene.Meshes.push_back(Vedo::ObjLoader::Load(loadPath.string(), ThreadCount));
+				}
+			} else if (statement == "mesh") {
+				Scene.Meshes.push_back(Vedo::Mesh::Make());
+			}
+			if (statement != "sphere") {
+				object->Shape	 = Vedo::MeshGeometry;
+				object->Geometry = Scene.Meshes.empty() ? nullptr : Scene.Meshes.back().get();
+			}
+
+			Scene.Objects.push_back(std::move(object));
+		} else if (statement == "vertex" && !Scene.Meshes.empty()) {
+			Scene.Meshes.back()->AddVertex(ParseVector(stream));
+		} else if (statement == "triangle" && !Scene.Meshes.empty()) {
+			uint32_t first, second, third;
+			stream >> first >> second >> third;
+			Scene.Meshes.back()->AddTriangle(first, second, third);
+		} else {
+			printf("Unknown statement \"%s\" at line %d.\n", statement.c_str(), lineNumber);
+
+			return false;
+		}
+
+		if (stream.fail()) {
+			printf("Invalid \"%s\" statement at line %d.\n", statement.c_str(), lineNumber);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Usage: vedoSceneConverter <input.txt> <output.vedo> [threads], threads is 0 for the count of the cores
+ */
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		printf("Usage: vedoSceneConverter <input.txt> <output.vedo> [threads]\n");
+
+		return -1;
+	}
+
+	int thread = argc > 3 ? std::atoi(argv[3]) : 0;
+
+	try {
+		TextScene scene;
+		scene.Camera.Ratio		   = 16.f / 9.f;
+		scene.Camera.Width		   = 640;
+		scene.Camera.SPP		   = 100;
+		scene.Camera.Depth		   = 50;
+		scene.Camera.FOV		   = 90;
+		scene.Camera.FocusDistance = 10;
+		scene.Camera.DeFocusAngle  = 0;
+		scene.Camera.LookFrom	   = Vedo::Vec3{0, 0, 10};
+		scene.Camera.LookAt		   = Vedo::Vec3{0, 0, 0};
+		scene.Camera.VUP		   = Vedo::Vec3{0, 1, 0};
+		if (!ParseScene(argv[1], scene, thread)) {
+			printf("Could not read the scene \"%s\".\n", argv[1]);
+
+			return -1;
+		}
+
+		std::vector<Vedo::Object *> objects;
+		for (auto &object : scene.Objects) {
+			objects.push_back(object.get());
+		}
+
+		auto bvh = Vedo::BVH::MakeParallel(objects, thread);
+		Vedo::SceneFile::Save(argv[2], scene.Camera, scene.Materials, objects, *bvh);
+
+		// Open the written file to report how fast it is loaded
+		auto start	= std::chrono::steady_clock::now();
+		auto file	= Vedo::SceneFile::Open(argv[2]);
+		auto opened = std::chrono::steady_clock::now();
+		auto tree	= file->MakeBVH();
+		auto end	= std::chrono::steady_clock::now();
+
+		printf("Converted %zu objects, %d materials, %zu meshes and %zu BVH nodes (built in %.2f ms) into %s of %.2f "
+			   "MB, opened in %.3f ms, BVH taken in %.3f ms.\n",
+			   objects.size(), scene.Materials.Size(), scene.Meshes.size(), tree->Nodes().size(), bvh->BuildTime(),
+			   argv[2],
+			   static_cast<double>(file->Size()) / (1024.0 * 1024.0),
+			   std::chrono::duration<double, std::milli>(opened - start).count(),
+			   std::chrono::duration<double, std::milli>(end - opened).count());
+	} catch (std::exception &e) {
+		printf("Error occurred: %s.", e.what());
+
+		return -1;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The tester for Vedo scene file
+ */
+
+#include <include/render/VeSceneFile.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+int main() {
+	std::mt19937						  random(20231);
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	std::uniform_real_distribution<float> offset(-1.f, 1.f);
+
+	Vedo::Camera camera;
+	camera.Ratio			 = 4.f / 3.f;
+	camera.Width			 = 320;
+	camera.SPP				 = 16;
+	camera.Depth			 = 8;
+	camera.FOV				 = 60;
+	camera.FocusDistance	 = 10;
+	camera.DeFocusAngle		 = 0.5f;
+	camera.LookFrom			 = Vedo::Vec3{13, 2, 3};
+	camera.LookAt			 = Vedo::Vec3{0, 0, 0};
+	camera.VUP				 = Vedo::Vec3{0, 1, 0};
+	camera.Sampler			 = Vedo::SobolSampler;
+	camera.RouletteDepth	 = 5;
+	camera.AdaptiveThreshold = 0.01f;
+
+	// A million triangles shared by two objects, and some spheres between them
+	auto mesh = Vedo::Mesh::Make();
+	for (int triangle = 0; triangle < 1000000; ++triangle) {
+		auto center = Vedo::Vec3{position(random), position(random), position(random)};
+		auto first	= mesh->AddVertex(center + Vedo::Vec3{offset(random), offset(random), offset(random)});
+		auto second = mesh->AddVertex(center + Vedo::Vec3{offset(random), offset(random), offset(random)});
+		auto third	= mesh->AddVertex(center + Vedo::Vec3{offset(random), offset(random), offset(random)});
+		mesh->AddTriangle(first, second, third);
+	}
+
+	// The objects share a few materials, the same material added again is not stored twice
+	Vedo::MaterialTable materials;
+	for (int index = 0; index < 8; ++index) {
+		Vedo::Material material;
+		material.Kind	= Vedo::MetalMaterial;
+		material.Albedo = Vedo::Vec3{offset(random), offset(random), offset(random)};
+		material.Fuzz	= 0.5f;
+		materials.Add(material);
+	}
+	auto deduplicated = materials.Add(materials[3]) == 3 && materials.Size() == 8;
+
+	std::vector<Vedo::Object> objects(1000);
+	for (size_t index = 0; index < objects.size(); ++index) {
+		auto &object	= objects[index];
+		object.Material = static_cast<int>(index % 8);
+		object.Shape	= Vedo::SphereGeometry;
+		object.Center	= Vedo::Vec3{position(random), position(random), position(random)};
+		object.Radius	= 1.f;
+	}
+	for (int index : {10, 500}) {
+		objects[index].Shape	= Vedo::MeshGeometry;
+		objects[index].Geometry = mesh.get();
+	}
+
+	std::vector<Vedo::Object *> objectPointers;
+	for (auto &object : objects) {
+		objectPointers.push_back(&object);
+	}
+
+	try {
+		auto bvh = Vedo::BVH::MakeParallel(objectPointers);
+		Vedo::SceneFile::Save("vedo_test.vedo", camera, materials, objectPointers, *bvh);
+
+		auto start = std::chrono::steady_clock::now();
+		auto file  = Vedo::SceneFile::Open("vedo_test.vedo");
+		auto end   = std::chrono::steady_clock::now();
+
+		// The shared mesh is stored once, and the loaded scene should be the same as the saved one
+		auto loaded	 = file->Objects();
+		auto matched = deduplicated && loaded.size() == objects.size() && file->Meshes().size() == 1;
+		for (size_t index = 0; matched && index < objects.size(); ++index) {
+			auto &saved = objects[index];
+			auto &load	= *loaded[index];
+			matched		= saved.Material == load.Material && saved.Shape == load.Shape && saved.Center == load.Center &&
+					  (saved.Geometry == nullptr) == (load.Geometry == nullptr);
+		}
+
+		matched = matched && file->Materials().Size() == materials.Size();
+		for (int index = 0; matched && index < materials.Size(); ++index) {
+			auto &saved = materials[index];
+			auto &load	= file->Materials()[index];
+			matched		= saved.Kind == load.Kind && saved.Albedo == load.Albedo && saved.Fuzz == load.Fuzz &&
+					  saved.IndexRefraction == load.IndexRefraction;
+		}
+
+		auto &loadedMesh = *file->Meshes().front();
+		matched			 = matched && loadedMesh.TriangleCount() == mesh->TriangleCount() &&
+				   std::equal(mesh->Indices().begin(), mesh->Indices().end(), loadedMesh.Indices().begin()) &&
+				   std::equal(mesh->X().begin(), mesh->X().end(), loadedMesh.X().begin());
+		matched = matched && file->SceneCamera().LookFrom == camera.LookFrom && file->SceneCamera().FOV == camera.FOV;
+		matched = matched && file->SceneCamera().Sampler == camera.Sampler &&
+				  file->SceneCamera().RouletteDepth == camera.RouletteDepth &&
+				  file->SceneCamera().AdaptiveThreshold == camera.AdaptiveThreshold;
+
+		auto tree = file->MakeBVH();
+		matched	  = matched && tree->Nodes().size() == bvh->Nodes().size();
+		for (size_t index = 0; matched && index < bvh->Nodes().size(); ++index) {
+			auto &saved = bvh->Nodes()[index];
+			auto &load	= tree->Nodes()[index];
+			matched		= saved.BoundMin == load.BoundMin && saved.BoundMax == load.BoundMax &&
+					  saved.Escape == load.Escape && saved.Object == load.Object && saved.Triangle == load.Triangle;
+		}
+
+		printf("%zu triangles and %zu objects, %.2f MB opened in %.3f ms, %s.\n", mesh->TriangleCount(), objects.size(),
+			   static_cast<double>(file->Size()) / (1024.0 * 1024.0),
+			   std::chrono::duration<double, std::milli>(end - start).count(), matched ? "matched" : "mismatched");
+		if (!matched) {
+			return -1;
+		}
+	} catch (std::exception &e) {
+		printf("Error occurred: %s.", e.what());
+
+		return -1;
+	}
+
+	// A file with a vertex index out of range should be refused, the renders would read beyond the mapping
+	{
+		std::fstream file("vedo_test.vedo", std::ios::binary | std::ios::in | std::ios::out);
+		uint64_t	 indexOffset = 0;
+		// The index section is the eighth of the table behind the magic, the version and the byte order
+		file.seekg(16 + 7 * 16);
+		file.read(reinterpret_cast<char *>(&indexOffset), sizeof(indexOffset));
+		file.seekp(static_cast<std::streamoff>(indexOffset));
+		uint32_t index = 0xFFFFFFFFu;
+		file.write(reinterpret_cast<const char *>(&index), sizeof(index));
+	}
+	try {
+		Vedo::SceneFile::Open("vedo_test.vedo");
+
+		printf("The file with an invalid index is opened.\n");
+		return -1;
+	} catch (Vedo::SceneFileInvalidFormat &) {
+	}
+
+	// A file of another version should be refused
+	{
+		std::fstream file("vedo_test.vedo", std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(8);
+		uint32_t version = Vedo::SceneFile::Version + 1;
+		file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+	}
+	try {
+		Vedo::SceneFile::Open("vedo_test.vedo");
+
+		printf("The file of another version is opened.\n");
+		return -1;
+	} catch (Vedo::SceneFileInvalidFormat &) {
+	}
+
+	std::remove("vedo_test.vedo");
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023~Now Margoo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * \file main.cpp
+ * \brief The benchmark for Vedo shader preprocessor
+ */
+
+#include <include/math/VeVector.h>
+#include <include/shader/VeShaderStructure.h>
+
+#include <chrono>
+
+class Sphere : public Vedo::ShaderStructure<Sphere> {
+public:
+	Sphere(Vedo::Vec3 ICenter, const float &IFloat) : Center(ICenter), Radius(IFloat) {
+	}
+
+public:
+	static constexpr auto ShaderFields() {
+		return Vedo::MakeShaderFields(Vedo::ShaderFieldOf<&Sphere::Center>("center"),
+									  Vedo::ShaderFieldOf<&Sphere::Radius>("radius"));
+	}
+	[[nodiscard]] std::string Type() const override {
+		return "Sphere";
+	}
+
+public:
+	Vedo::Vec3 Center;
+	float	   Radius;
+};
+
+/**
+ * Make a large Vedo shader, which contains comments, link variables and an uniform array
+ * @param FunctionCount The count of the generated functions
+ * @return The shader code
+ */
+std::string MakeLargeShader(int FunctionCount) {
+	std::string code = "struct Sphere {\n    vec3 center;\n    float radius;\n};\n\n@uniform(array)\nSphere test;\n\n";
+	for (int count = 0; count < FunctionCount; ++count) {
+		code.append(std::format("// Generated function {0}, it is a comment with @uniform and $Scale$ inside\n"
+								"float function{0}(vec2 uv) {{\n"
+								"    float value = dot(uv, vec2({0}.0, $Scale$));\n"
+								"    /* Block comment */\n"
+								"    for (int i = 0; i < $Length$; ++i) {{\n"
+								"        value += test[0].radius * float(i) * 0.5;\n"
+								"    }}\n"
+								"    return fract(value);\n"
+								"}}\n",
+								count));
+	}
+	code.append("half4 main(vec2 coord) {\n    init_vedo();\n    return half4(function0(coord));\n}\n");
+
+	return code;
+}
+
+/**
+ * Measure the preprocessor throughput
+ * @param Name The name of the case
+ * @param FunctionCount The count of the generated functions
+ * @param ObjectCount The count of the structures in the uniform array
+ * @param Mode The uniform mode of the array
+ */
+void Measure(const char *Name, int FunctionCount, int ObjectCount, Vedo::ShaderUniformMode Mode) {
+	std::vector<Sphere>	   spheres(ObjectCount, Sphere(Vedo::Vec3{1.f, 2.f, 3.f}, 0.5f));
+	std::vector<Sphere *> uniforms;
+	for (auto &sphere : spheres) {
+		uniforms.push_back(&sphere);
+	}
+
+	auto code	= MakeLargeShader(FunctionCount);
+	auto shader = Vedo::Shader::MakeFromString(code);
+	shader->BindUniform("Scale", 2);
+	shader->BindUniform("Length", 4);
+	shader->BindUniformArray("test", uniforms, Mode);
+
+	// The first pass parses the code, it is measured separately
+	std::string output;
+	const auto	parseBegin = std::chrono::steady_clock::now();
+	shader->Preprocess(output);
+	const std::chrono::duration<double> parseDuration = std::chrono::steady_clock::now() - parseBegin;
+
+	const int  iteration = 50;
+	const auto begin	 = std::chrono::steady_clock::now();
+	for (int count = 0; count < iteration; ++count) {
+		// Relink with a new value every pass, like reseeding the shader every frame
+		shader->BindUniform("Scale", count);
+		shader->Preprocess(output);
+	}
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+
+	const double seconds   = duration.count() / iteration;
+	const double megabytes = static_cast<double>(code.size()) / (1024.0 * 1024.0);
+	printf("%-24s input %8.2f KiB, output %8.2f KiB, parse %8.3f ms, relink %8.3f ms/pass, %8.2f MiB/s\n", Name,
+		   code.size() / 1024.0, output.size() / 1024.0, parseDuration.count() * 1000.0, seconds * 1000.0,
+		   megabytes / seconds);
+}
+
+int main() {
+	try {
+		Measure("small shader", 16, 8, Vedo::ShaderUniformMode::Inline);
+		Measure("large shader", 4096, 8, Vedo::ShaderUniformMode::Inline);
+		Measure("large shader, packed", 4096, 4096, Vedo::ShaderUniformMode::Packed);
+		Measure("large uniform, inline", 16, 4096, Vedo::ShaderUniformMode::Inline);
+	} catch (std::exception &e) {
+		printf("Error occurred: %s.", e.what());
+
+		exit(-1);
+	}
+
+	return 0;
+}